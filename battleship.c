@@ -3,12 +3,86 @@
 #include <string.h>
 #include <ctype.h>
 #include <time.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdatomic.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1 // SSE2/AVX2/AVX-512 kernels are compiled per function and picked at runtime
+#include <immintrin.h>
+#endif
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <sys/file.h>
+#endif
 
 #define GRID_SIZE 10
 #define SHIP_TYPES 4
 #define MAX_NAME_LENGTH 20
 #define MAX_INPUT_LENGTH 50
 #define MAX_RADAR_SWEEPS 3
+#define MAX_SIM_TURNS 400
+#define SPECIAL_MOVE_TYPES 4
+#define PLACEMENT_CORPUS_FILE "placements.log"
+#define PLACEMENT_PRIOR_FILE "placement_prior.bin"
+#define PLACEMENT_PRIOR_MAGIC "BSPRIOR1"
+#define PRIOR_UNIFORM_WEIGHT 16 // Table weight of a placement seen exactly as often as uniform
+#define PLACEMENT_SEARCH_MS 30     // Setup latency budget for the HARD bot's layout search
+#define PLACEMENT_CANDIDATES 48    // Upper bound on layouts scored within that budget
+#define PLACEMENT_SHORTLIST 6      // Best layouts kept; the final one is drawn among them
+#define MAX_TUNED_PARAMS 8
+#define TUNE_POPULATION 8         // Candidates per tuner generation (lambda), evaluated side by side
+#define TRANSPOSITION_BUCKETS 2048 // Power of two; each bucket holds two entries
+#define DENSITY_WORDS ((CELL_COUNT + 1) / 2) // A cached grid packs two cell values per 64-bit word
+#define SYMMETRIES 8 // Dihedral group of the square board
+#define OPENING_BOOK_FILE "opening_book.bin"
+#define OPENING_BOOK_MAGIC "BSBOOK01"
+#define OPENING_BOOK_DEPTH 8      // Shots covered by the book, branching on hit/miss
+#define OPENING_BOOK_SAMPLES 4000 // Consistent layouts sampled per book position
+#define BATCH_LANES 256           // Games advanced together by the lockstep simulator
+#define BATCH_POLICY 3            // Stats label of the lockstep simulator's hunter, after the difficulty levels
+#define STAT_POLICIES 4           // Difficulty levels plus BATCH_POLICY
+#define MAX_BATCH_THREADS 8       // Lockstep simulators run side by side, each on its own share of games
+#define FULL_ROW ((unsigned short)((1 << GRID_SIZE) - 1))
+#define HARD_MOVE_BUDGET_MS 5.0   // Default deadline of the HARD bot's anytime search
+#define BELIEF_BATCH 16           // Layout samples drawn between deadline checks
+#define BELIEF_GIVE_UP 256        // Consecutive failed draws after which the knowledge is deemed inconsistent
+#define HEADLESS_BELIEF_SAMPLES 4096 // Layout samples per HARD move in headless runs, instead of the deadline
+#define PONDER_MAX_SAMPLES (1 << 20) // Pondering stops on its own after this many layouts
+#define PARTICLE_COUNT 4096       // Default population of a HARD bot's particle filter (--particles)
+#define MAX_PARTICLES (1 << 20)
+#define PARTICLE_SWEEPS 8         // Rejuvenation moves per particle per turn
+#define PARTICLE_REFILL_DIVISOR 4 // Fewer survivors than capacity / this are topped up with fresh draws
+#define PARTICLE_SEED_ATTEMPTS 16 // Exact draws tried per particle before seeding goes hit-first
+#define MAX_PARTICLE_FILTERS 2    // Bots whose particles are kept at once (both sides of a bot game)
+#define PLACEMENT_NONE 0xFF       // Placement byte of a ship a particle no longer holds (sunk)
+#define MAX_GAME_ACTIONS 512      // Actions a game record keeps for the post-game analysis
+#define ANALYSIS_SAMPLES 1024     // Layouts sampled per analysed move
+#define MAX_ANALYSIS_THREADS 8
+#define JOURNAL_FILE "battleship.journal"
+#define JOURNAL_GROUP_RECORDS 64  // Records written before a group commit forces the fsync
+#define JOURNAL_COMMIT_MS 20.0    // Longest a written record waits for its fsync
+#define SPECTATOR_CHANNEL "/battleship-spectate" // Shared-memory object games broadcast into
+#define SPECTATOR_MAGIC "BSSPEC01"
+#define SPECTATOR_RING_SLOTS 1024 // Power of two; a viewer further behind than this resyncs
+#define SPECTATOR_POLL_MS 10
+#define CELL_COUNT (GRID_SIZE * GRID_SIZE)
+#define CELL_MASK_WORDS ((CELL_COUNT + 63) / 64) // Flat cell masks: bit i is cell index i
+#define MAX_LEGAL_ACTIONS (4 * CELL_COUNT + 2 * GRID_SIZE) // Fire, radar, smoke, artillery, torpedo lines
+#define POSITION_TEXT_MAX 640     // Room for the longest line formatPosition writes, newline excluded
+#define SALVO_PER_SHIP -1         // salvoShots setting for one shot per ship still afloat
+#define MAX_SALVO_SHOTS 10        // Largest salvo; ten coordinates still fit one input line
+#define SALVO_SAMPLES 4096        // Layouts the salvo search weighs at most
+
+#if GRID_SIZE > 16
+#error "Bitboard rows are 16-bit masks; GRID_SIZE must not exceed 16"
+#endif
 
 typedef enum { false, true } bool;
 
@@ -34,12 +108,267 @@ typedef struct {
     int hits;
     bool sunk;
     char symbol;
+    Coordinate position; // Bow of the ship, filled in by locateShips once placement finishes
+    char orientation;    // 'h' or 'v'
 } Ship;
 
 typedef struct {
     Ship ships[SHIP_TYPES];
 } Fleet;
 
+// One bit per cell: bit x of rows[y] is cell (x, y)
+typedef struct {
+    unsigned short rows[GRID_SIZE];
+} Bitboard;
+
+// Bit-sliced per-cell counts 0..4: bit x of bits[k].rows[y] is bit k of the count at (x, y)
+typedef struct {
+    Bitboard bits[3];
+} WindowCounts;
+
+// Grid reductions behind a runtime CPU dispatch. Every implementation gives bit-identical results,
+// so the choice only affects speed.
+typedef struct {
+    const char* name;
+    // Sets bit i of mask for every cells[i] == match
+    void (*matchMask)(const char* cells, char match, unsigned long long mask[CELL_MASK_WORDS]);
+    // Largest values[i] over the cells set in mask (-1 if none); ties get every index holding it,
+    // ascending
+    int (*maskedArgmax)(const int* values, const unsigned long long mask[CELL_MASK_WORDS], int* ties, int* tieCount);
+} GridKernels;
+
+// Struct-of-arrays store of the lockstep simulator's games. Every field is its own array indexed by
+// lane, so batch code touches only the fields it needs. Boards are row masks and ship placements are
+// one byte (cell index, top bit set when vertical).
+typedef struct {
+    int capacity;
+    unsigned short* shipRows[2][GRID_SIZE];        // Cells occupied by each side's ships
+    unsigned short* shotRows[2][GRID_SIZE];        // Cells each side has fired at on the other's grid
+    unsigned char* placements[2][SHIP_TYPES];
+} GameStore;
+
+// Per-lane scratch of the lockstep simulator, laid out [..][row][lane] like the GameStore arrays
+typedef struct {
+    unsigned short shipMasks[2][SHIP_TYPES][GRID_SIZE][BATCH_LANES];
+    unsigned short sunkRows[2][GRID_SIZE][BATCH_LANES];   // Cells of sunk ships, excluded from targeting
+    unsigned short candidates[GRID_SIZE][BATCH_LANES];
+    unsigned char sunk[2][SHIP_TYPES][BATCH_LANES];
+    unsigned short shots[2][BATCH_LANES];
+    unsigned char firstSide[BATCH_LANES];
+    unsigned char active[BATCH_LANES];
+    unsigned int rng[BATCH_LANES];
+} BatchScratch;
+
+// A sink announcement the attribution tracker could not yet pin to a line of hits
+typedef struct {
+    Coordinate coord; // Shot that sank the ship
+    int size;
+} SunkShipReport;
+
+typedef enum {
+    ACTION_FIRE,
+    ACTION_RADAR,
+    ACTION_SMOKE,
+    ACTION_ARTILLERY,
+    ACTION_TORPEDO,
+    ACTION_SALVO // A further shot of the salvo begun by the preceding ACTION_FIRE
+} ActionType;
+
+// Packed legal action: ActionType above the low byte, cell index or torpedo line (row, or GRID_SIZE +
+// column, as in GameAction) in it
+typedef unsigned short ActionCode;
+#define ACTION_CODE(type, target) ((ActionCode)(((type) << 8) | (target)))
+#define ACTION_CODE_TYPE(code) ((ActionType)((code) >> 8))
+#define ACTION_CODE_TARGET(code) ((code) & 0xFF)
+
+// One resolved action as the game record keeps it
+typedef struct {
+    unsigned char side;    // Index into GameRecord.players
+    unsigned char type;    // ActionType
+    unsigned char target;  // Cell index; torpedo: row, or GRID_SIZE + column
+    unsigned char outcome; // Cells newly hit; radar: 1 if ships were detected, 2 if smoke blocked it
+} GameAction;
+
+typedef enum {
+    JOURNAL_OPEN,   // Payload: JournalOpening
+    JOURNAL_ACTION, // Payload: GameAction
+    JOURNAL_CLOSE   // No payload; the session can no longer be resumed
+} JournalRecordKind;
+
+// Every journal record starts with this header; records are packed back to back
+typedef struct {
+    unsigned int session;
+    unsigned char kind;     // JournalRecordKind
+    unsigned char length;   // Payload bytes that follow the header
+    unsigned short reserved;
+} JournalHeader;
+
+// Both sides as placed, in the order they move
+typedef struct {
+    char names[2][MAX_NAME_LENGTH];
+    unsigned char placements[2][SHIP_TYPES]; // Cell index, top bit set when vertical (as in GameStore)
+    unsigned char difficulty[2];
+    unsigned char flags;                     // Bit 0/1: side is a bot, bit 2: hard tracking mode
+} JournalOpening;
+
+// Append-only journal shared by every session of the process. Records go to the kernel with one
+// write() each, so they survive the process dying; fsyncs are batched across sessions (group commit).
+typedef struct {
+    int fd;                   // -1 while journaling is off
+    unsigned int nextSession;
+    int pending;              // Records written since the last fsync
+    double oldestPending;     // When the first of them was written
+} Journal;
+
+typedef enum {
+    SPECTATE_NEW_GAME, // The snapshot was rewritten for a new game
+    SPECTATE_MISS,
+    SPECTATE_HIT,
+    SPECTATE_SINK,     // Hit that sank ship
+    SPECTATE_WIN       // side won
+} SpectatorEventKind;
+
+// One broadcast event, exactly eight bytes so a ring slot is written and read as a single word
+typedef struct {
+    unsigned int sequence; // 1 for the first event ever published on the channel
+    unsigned char kind;    // SpectatorEventKind
+    unsigned char side;    // Side that fired (or won)
+    unsigned char cell;    // Cell index on the other side's grid
+    unsigned char ship;    // Ship index for SPECTATE_SINK
+} SpectatorEvent;
+
+// Full picture of the game for a viewer joining or resyncing; covers events up to lastEvent
+typedef struct {
+    unsigned int lastEvent;
+    char names[2][MAX_NAME_LENGTH];
+    char grids[2][GRID_SIZE][GRID_SIZE]; // Each side's own grid: ships, 'X' hits, 'o' misses
+} SpectatorSnapshot;
+
+// Layout of the shared-memory channel: written by the one game process, mapped read-only by any
+// number of viewers. The producer never waits for anyone; a viewer that falls more than a ring behind
+// sees a slot with a newer sequence than it expected and starts over from the snapshot.
+typedef struct {
+    char magic[8];
+    unsigned int head;            // Sequence of the newest published event
+    unsigned int snapshotVersion; // Seqlock: odd while either snapshot is being changed
+    SpectatorSnapshot snapshot;   // Live
+    SpectatorSnapshot opening;    // As of the last SPECTATE_NEW_GAME, so viewers can follow from the start
+    unsigned long long ring[SPECTATOR_RING_SLOTS]; // SpectatorEvent words, slot = sequence % slots
+} SpectatorChannel;
+
+// Every placement of each unsunk ship that the bot's knowledge still allows, as cell masks
+typedef struct {
+    int count[SHIP_TYPES];
+    Bitboard masks[SHIP_TYPES][2 * GRID_SIZE * GRID_SIZE];
+} PlacementSet;
+
+// Knowledge a sampled fleet has to agree with; all empty for a fresh random fleet
+typedef struct {
+    Bitboard must;    // Cells some ship must cover (hits, radar contacts)
+    Bitboard mustNot; // Cells no ship may cover (misses, radar-clear cells, ships already on the grid)
+    Bitboard hits;    // Cells already hit: an unsunk ship cannot lie entirely on them
+} FleetConstraints;
+
+// Placement tables of an exact uniform fleet sampler, built once per set of constraints. Masks are
+// flat cell masks (bit i is cell index i) so an overlap test is CELL_MASK_WORDS ANDs.
+typedef struct {
+    int shipCount;                  // Ships to place, largest first
+    int ships[SHIP_TYPES];          // Their indices in the fleet
+    int count[SHIP_TYPES];          // Placements per ship index
+    unsigned long long masks[SHIP_TYPES][2 * CELL_COUNT][CELL_MASK_WORDS];
+    unsigned char placements[SHIP_TYPES][2 * CELL_COUNT]; // Cell index, top bit set when vertical
+    unsigned long long must[CELL_MASK_WORDS];
+} FleetSampler;
+
+// Fleet layouts consistent with what a bot knows, tallied until its move deadline
+typedef struct {
+    int samples;
+    int cellHits[GRID_SIZE][GRID_SIZE];    // Samples with a ship on the cell
+    int windowSinks[GRID_SIZE][GRID_SIZE]; // Samples where artillery anchored there finishes a ship
+    int rowSinks[GRID_SIZE];               // Same for a torpedo down each row and column
+    int columnSinks[GRID_SIZE];
+} BeliefSamples;
+
+// What the layout sampler needs from a bot's knowledge, self-contained so a pondering thread can
+// work on a snapshot while the game goes on
+typedef struct {
+    PlacementSet set;
+    Bitboard hits;      // Live hits
+    Bitboard mustCover; // Live hits and untargeted radar contacts
+    Bitboard blocked;   // Misses, hits of sunk ships and radar-clear cells
+} BeliefInputs;
+
+// Targeting-mode queue of the bot: an indexed binary max-heap of cells keyed by hit probability, plus
+// an occupancy bitboard so membership checks never scan the heap. The view and sunk ships the keys
+// were computed against are kept, so a pop re-keys only the entries the knowledge since has touched.
+typedef struct {
+    unsigned char cells[GRID_SIZE * GRID_SIZE];
+    int keys[GRID_SIZE * GRID_SIZE];               // -1 until the entry is first keyed
+    unsigned char slots[GRID_SIZE * GRID_SIZE];    // Heap index of each queued cell
+    int count;
+    Bitboard queued;
+    char keyedView[GRID_SIZE][GRID_SIZE];
+    unsigned char keyedSunk;                       // Bit per ship
+} TargetQueue;
+
+// The bot's own board as the opponent's density model sees it, summed over every smoke window.
+// The opponent's density is kept together with the view it was computed from, so each new shot
+// only patches the placements through the cells it changed.
+typedef struct {
+    bool valid;
+    char view[GRID_SIZE][GRID_SIZE];    // Opponent's densityView the density matches
+    Fleet fleetView;                    // Our fleet as the grid tells, derived again after each sink
+    int shipsSunk;
+    bool parityHunt;
+    Bitboard exposed;                   // Unhit, unsmoked ship cells
+    int density[GRID_SIZE][GRID_SIZE];  // Opponent's hunt density over our board
+    int exposure[GRID_SIZE][GRID_SIZE]; // Per window anchor: density on exposed cells
+} ThreatMap;
+
+// Heuristic constants of the bot, exposed so the tuner can search over them
+typedef struct {
+    int hitWeight;          // Probability increment for placements overlapping a hit
+    int plainWeight;        // Probability increment for every other placement
+    int checkerboardHunt;   // 1 = only checkerboard placements count while there are no hits
+    int easyCadence;        // Length in turns of the EASY bot's special move cycle
+    int radarChance[3];     // Percent chance per DifficultyLevel
+    int artilleryChance[3];
+    int torpedoChance[3];
+    int smokeChance[3];
+} BotParams;
+
+// One cached probability grid. lock is the state key XOR a checksum of the grid, so a reader that
+// races a writer sees a mismatch instead of a torn grid (lockless hashing, no mutex needed). Every
+// word is accessed atomically but relaxed: the XOR check, not memory ordering, is what validates an
+// entry, and it also rejects a grid stitched together from two writers.
+typedef struct {
+    _Atomic unsigned long long lock;
+    _Atomic unsigned long long lastUsed;
+    _Atomic unsigned long long density[DENSITY_WORDS];
+} TranspositionEntry;
+
+typedef struct {
+    TranspositionEntry entries[TRANSPOSITION_BUCKETS][2];
+    _Atomic unsigned long long clock;
+    _Atomic unsigned long long lookups;
+    _Atomic unsigned long long hits;
+    _Atomic unsigned long long stores;
+    _Atomic unsigned long long evictions;
+} TranspositionTable;
+
+// One book position while building: canonical tracking-grid key and the canonical cell to fire at
+typedef struct {
+    unsigned long long key;
+    unsigned char cell;
+} OpeningEntry;
+
+typedef struct {
+    const char* name;
+    size_t offset; // Byte offset of the int inside BotParams
+    int min;
+    int max;
+} TunedParam;
+
 typedef struct {
     char name[MAX_NAME_LENGTH];
     char grid[GRID_SIZE][GRID_SIZE];
@@ -52,14 +381,156 @@ typedef struct {
     bool torpedoAvailable;
     bool isBot;
     SmokeScreen smokeScreens[SHIP_TYPES];
-    Coordinate potentialTargets[GRID_SIZE * GRID_SIZE];
-    int potentialTargetCount;
+    TargetQueue potentialTargets;
+    Bitboard resolvedHits;                    // Hits attributed to sunk ships; the density treats them as misses
+    SunkShipReport pendingSinks[SHIP_TYPES];  // Sinks whose hits are still ambiguous
+    int pendingSinkCount;
+    ThreatMap threat;
+    Bitboard radarContacts; // Cells a radar sweep showed to hold a ship
+    Bitboard radarClear;    // Cells a radar sweep showed to be water
+    Bitboard shotHistory;   // Every cell this player has fired at, kept even when hardMode hides misses
     Coordinate lastArtilleryCoord;
     int lastArtilleryHits;
     DifficultyLevel difficulty;
     int turnNumber; // Added to track the number of turns
+    int artilleryUsed;
+    int torpedoUsed;
+    const BotParams* params;
 } Player;
 
+// Background sampling for a bot while the human decides. The human's move never changes what the
+// bot knows about the human's fleet, so one belief is valid whatever the human ends up doing.
+typedef struct {
+    Player* owner;         // Bot the belief belongs to, NULL when idle
+    BeliefInputs inputs;
+    BeliefSamples belief;
+    unsigned int rng;
+    bool running;
+    bool cancel;
+#ifndef _WIN32
+    pthread_t thread;
+    pthread_mutex_t lock;  // Guards cancel
+#endif
+} PonderState;
+
+// One fleet hypothesis of a particle filter: a placement byte per ship and the cells they cover
+typedef struct {
+    unsigned char placements[SHIP_TYPES];
+    unsigned long long occupied[CELL_MASK_WORDS];
+} Particle;
+
+// A HARD bot's belief about the opponent's fleet, carried from turn to turn: a fixed-size population
+// of fleets that explain everything absorbed so far, and placement tables narrowed to the same
+// evidence. Shots and radar are exact, so a particle's weight is 1 or 0: reweighting drops the
+// particles new evidence rules out and resampling copies the survivors.
+typedef struct {
+    Player* owner;               // NULL while the slot is free
+    const Fleet* fleet;
+    unsigned long long lastUsed;
+    int turn;                    // Owner's turnNumber when evidence was last absorbed
+    FleetConstraints absorbed;
+    bool sunk[SHIP_TYPES];
+    int capacity;                // Particles allocated in each buffer
+    int count;
+    Particle* particles;
+    Particle* spare;             // Resampling target, swapped with particles
+    FleetSampler sampler;
+    unsigned long long shipCells[SHIP_TYPES][256][CELL_MASK_WORDS]; // Flat mask of each placement byte
+    unsigned int rng;
+} ParticleFilter;
+
+// Unhit cells of every ship in each layout the salvo search weighs; all zero for a sunk ship
+typedef struct {
+    int count;
+    unsigned long long ships[SALVO_SAMPLES][SHIP_TYPES][CELL_MASK_WORDS];
+} SalvoSamples;
+
+// A game state rebuilt from one line of position notation; [toMove] moves next
+typedef struct {
+    Player players[2];
+    Fleet fleets[2];
+    int toMove;
+    bool hardMode;
+} Position;
+
+// A file of positions, one per line, mapped for the lifetime of the process. Lines are only indexed
+// when the suite loads and parsed when asked for, so millions of them load in one pass of memchr.
+typedef struct {
+    const char* text;
+    size_t size;
+    size_t count;
+    size_t* offsets; // Start of each position's line
+} PositionSuite;
+
+// Everything needed to replay a game: both sides right after placement, then every action in order
+typedef struct {
+    bool active;           // Actions are only logged while a record is open
+    Player* players[2];    // [0] moved first
+    Player opening[2];
+    Fleet openingFleets[2];
+    int count;
+    GameAction actions[MAX_GAME_ACTIONS];
+} GameRecord;
+
+// One move of a finished game: the mover's knowledge just before it, then the engine's verdict
+typedef struct {
+    Player view;           // Mover, with every miss on its tracking grid
+    Fleet targetFleet;
+    GameAction action;     // A salvo is one move: its first shot typed ACTION_SALVO, outcome summed
+    Bitboard salvo;        // Every cell of a salvo move
+    int moveNumber;        // Counted per side from 1
+    int samples;           // Layouts behind the verdict, 0 if none could be drawn
+    double expectedHits;   // Of the move actually played
+    GameAction best;       // Engine's best alternative and its expected hits
+    double bestHits;
+    double luck;           // Share of layouts that give the observed outcome
+} MoveAnalysis;
+
+// One game being journaled; actions by either player are appended under its id
+typedef struct {
+    bool open;
+    unsigned int id;
+    Player* players[2];    // [0] moved first
+} JournalSession;
+
+// A slice of the moves for one analysis thread: first, first + stride, ...
+typedef struct {
+    MoveAnalysis* moves;
+    int count;
+    int first;
+    int stride;
+} AnalysisWorker;
+
+// Outcome of one finished (or turn-capped) bot-vs-bot game
+typedef struct {
+    int policy[2];                 // DifficultyLevel or BATCH_POLICY; [0] moved first after the coin flip
+    int winner;                    // 0 or 1, -1 if the game hit MAX_SIM_TURNS
+    int winnerSeat;                // Winner in simulateGame argument order, -1 if unfinished
+    int turnsToWin;                // Winner's turn count
+    int specialMoves[SPECIAL_MOVE_TYPES]; // Radar, smoke, artillery, torpedo (both sides)
+    char hitGrid[2][GRID_SIZE][GRID_SIZE]; // Final boards, 'X' marks a hit cell
+} GameResult;
+
+// Streaming aggregates over any number of games; fixed size, mergeable
+typedef struct {
+    long long games;
+    long long unfinished;
+    long long matchups[STAT_POLICIES][STAT_POLICIES]; // [first policy][second policy]
+    long long wins[STAT_POLICIES][STAT_POLICIES];     // wins[a][b]: games won by policy a against policy b
+    long long firstMoverWins;
+    long long turnsHistogram[MAX_SIM_TURNS + 1];
+    long long specialMoves[SPECIAL_MOVE_TYPES];
+    long long hitHeatmap[GRID_SIZE][GRID_SIZE];
+} GameStats;
+
+// One thread's share of a batch simulation: its own games, stats and shot count, merged at the end
+typedef struct {
+    long long games;
+    long long totalShots;
+    bool ready; // False if the worker could not allocate its lanes
+    GameStats stats;
+} BatchWorker;
+
 void initializePlayer(Player* player, bool isBot, DifficultyLevel difficulty);
 void initializeGrid(char grid[GRID_SIZE][GRID_SIZE]);
 void displayGrid(char grid[GRID_SIZE][GRID_SIZE], bool showShips);
@@ -73,6 +544,7 @@ void gameLoop(Player* currentPlayer, Player* opponent, Fleet* currentFleet, Flee
 void performMove(Player* player, Player* opponent, Fleet* opponentFleet, bool hardMode);
 void performBotMove(Player* bot, Player* opponent, Fleet* opponentFleet, bool hardMode);
 int fire(Player* player, Player* opponent, Fleet* opponentFleet, Coordinate coord, bool hardMode, char* sunkShipName);
+int resolveShot(Player* player, Player* opponent, Fleet* opponentFleet, Coordinate coord, bool hardMode, char* sunkShipName);
 void radarSweep(Player* player, Player* opponent, Coordinate coord);
 bool smokeScreen(Player* player, Coordinate coord);
 void artillery(Player* player, Player* opponent, Fleet* opponentFleet, Coordinate coord, bool hardMode);
@@ -81,7 +553,10 @@ bool checkWin(Fleet* fleet);
 void updateShipStatus(Ship* ship);
 void unlockSpecialMoves(Player* player, Player* opponent);
 void displayTrackingGrid(Player* player, bool hardMode);
+void showHint(Player* player, Fleet* opponentFleet);
 bool isValidCommand(const char* command, Player* player);
+bool isActionAvailable(Player* player, ActionType type);
+int generateLegalActions(Player* player, ActionCode actions[MAX_LEGAL_ACTIONS]);
 void getInput(char* input, int size);
 void coordinateToString(Coordinate coord, char* coordStr);
 void toLowerCase(char* str);
@@ -91,15 +566,359 @@ Coordinate getRandomCoordinate();
 Coordinate getNextTarget(Player* bot, Fleet* opponentFleet);
 void addAdjacentTargets(Player* bot, Coordinate coord);
 void calculateProbabilityGrid(Player* bot, Fleet* opponentFleet, int probabilityGrid[GRID_SIZE][GRID_SIZE]);
+void computeProbabilityGrid(Player* bot, Fleet* opponentFleet, int probabilityGrid[GRID_SIZE][GRID_SIZE]);
+void accumulatePlacement(Player* bot, char view[GRID_SIZE][GRID_SIZE], bool parityHunt, int shipIdx, int size,
+                         int vertical, int x, int y, int sign, int probabilityGrid[GRID_SIZE][GRID_SIZE]);
 Coordinate getBestArtilleryTarget(Player* bot);
 int countUntargetedTilesInArtilleryArea(Player* bot, Coordinate coord);
 bool chooseTorpedoTarget(Player* bot, Player* opponent, Fleet* opponentFleet, bool hardMode);
+void launchTorpedo(Player* bot, Player* opponent, Fleet* opponentFleet, char targetType, int targetIndex, bool hardMode);
+void collectPlacements(Fleet* opponentFleet, Bitboard blocked, Bitboard hits, PlacementSet* set);
+unsigned int nextRandom(unsigned int* state);
+unsigned int randomBelow(unsigned int* state, unsigned int bound);
+void bitboardToCellMask(Bitboard board, unsigned long long mask[CELL_MASK_WORDS]);
+bool initializeFleetSampler(FleetSampler* sampler, const Fleet* fleet, const FleetConstraints* constraints);
+bool sampleFleet(const FleetSampler* sampler, unsigned int* rng, int picks[SHIP_TYPES], int maxAttempts);
+bool pruneFleetSampler(FleetSampler* sampler, const Fleet* fleet, const FleetConstraints* constraints);
+bool drawBeliefSample(const PlacementSet* set, Bitboard mustCover, Bitboard layout[SHIP_TYPES], unsigned int* rng);
+void accumulateBelief(BeliefSamples* belief, Bitboard layout[SHIP_TYPES], Bitboard hits);
+void prepareBeliefInputs(Player* bot, Fleet* opponentFleet, BeliefInputs* inputs);
+bool sampleBeliefBatch(const BeliefInputs* inputs, BeliefSamples* belief, unsigned int* rng, int* failures);
+bool sampleBelief(Player* bot, Fleet* opponentFleet, double deadline, BeliefSamples* belief);
+void startPondering(Player* bot, Fleet* opponentFleet);
+void stopPondering();
+bool takePonderedBelief(Player* bot, const BeliefInputs* inputs, BeliefSamples* belief);
+ParticleFilter* particleFilterFor(Player* bot);
+bool extendsEvidence(const ParticleFilter* filter, const Fleet* fleet, const FleetConstraints* evidence);
+unsigned char placementOfMask(Bitboard mask);
+bool particleExplains(const ParticleFilter* filter, const Particle* particle,
+                      const unsigned long long mustNot[CELL_MASK_WORDS], const unsigned long long hits[CELL_MASK_WORDS]);
+int seedParticles(ParticleFilter* filter, const BeliefInputs* inputs, int count, int target, double deadline);
+void rejuvenateParticle(ParticleFilter* filter, Particle* particle);
+bool updateParticleFilter(ParticleFilter* filter, Player* bot, const Fleet* fleet, const BeliefInputs* inputs, double deadline);
+void tallyParticles(const ParticleFilter* filter, const Fleet* fleet, Bitboard hits, BeliefSamples* belief);
+void startGameRecord(Player* first, Player* second, Fleet* firstFleet, Fleet* secondFleet);
+void logAction(Player* player, ActionType type, int target, int outcome);
+void replayAction(Player players[2], Fleet fleets[2], const GameAction* action, bool hardMode);
+void describeAction(const GameAction* action, char* text);
+Bitboard actionArea(const GameAction* action, Bitboard untargeted);
+void analyzeMove(MoveAnalysis* move, unsigned int rng);
+void* analysisThread(void* arg);
+void analyzeGame();
+void printAnalysisReport(MoveAnalysis* moves, int count, double elapsedMs);
+bool openJournal(const char* path);
+bool readJournalRecord(const unsigned char* data, size_t size, size_t* offset, JournalHeader* header,
+                       const unsigned char** payload);
+void journalAppend(JournalSession* session, JournalRecordKind kind, const void* payload, int length);
+void commitJournal();
+void beginJournalSession(JournalSession* session, Player* first, Player* second, Fleet* firstFleet,
+                         Fleet* secondFleet, bool hardMode);
+void endJournalSession(JournalSession* session);
+bool resumeSession(unsigned int id, const char* path);
+bool openSpectatorChannel();
+void beginBroadcast(Player* first, Player* second);
+void broadcastEvent(Player* player, SpectatorEventKind kind, Coordinate coord, int ship);
+bool readSpectatorSnapshot(const SpectatorChannel* channel, const SpectatorSnapshot* source, SpectatorSnapshot* copy);
+void showSpectatorView(const SpectatorSnapshot* snapshot, const char* lastEvent);
+void spectate();
+bool performAnytimeMove(Player* bot, Player* opponent, Fleet* opponentFleet, bool hardMode, double deadline,
+                        Coordinate* coord, int* result, char* sunkShipName);
+int salvoSize(Player* player);
+void fireSalvo(Player* player, Player* opponent, Fleet* opponentFleet, const Coordinate* shots, int count, bool hardMode);
+int gatherSalvoSamples(Player* bot, Fleet* opponentFleet, double deadline, SalvoSamples* samples);
+void salvoGains(const SalvoSamples* samples, const int cellHits[CELL_COUNT],
+                const unsigned long long chosen[CELL_MASK_WORDS], int gains[CELL_COUNT]);
+int bestSalvoCell(const int gains[CELL_COUNT], const unsigned long long candidates[CELL_MASK_WORDS],
+                  const unsigned long long chosen[CELL_MASK_WORDS], unsigned int* rng);
+int chooseSalvo(Player* bot, Fleet* opponentFleet, int count, double deadline, Coordinate shots[MAX_SALVO_SHOTS]);
+void performBotSalvo(Player* bot, Player* opponent, Fleet* opponentFleet, bool hardMode);
 void addPotentialTarget(Player* player, Coordinate coord);
-Coordinate getSmokeScreenCoordinateForBot(Player* bot);
+void initializeTargetQueue(TargetQueue* queue);
+void swapTargets(TargetQueue* queue, int a, int b);
+void siftTargetUp(TargetQueue* queue, int index);
+void siftTargetDown(TargetQueue* queue, int index);
+void removeTopTarget(TargetQueue* queue);
+int targetPriority(Player* bot, Fleet* opponentFleet, char view[GRID_SIZE][GRID_SIZE], Coordinate coord);
+bool isResolvedHit(Player* player, int x, int y);
+void densityView(Player* bot, char view[GRID_SIZE][GRID_SIZE]);
+int findSunkShipLines(Player* player, SunkShipReport report, Bitboard* line);
+void resolveHitClusters(Player* player);
+void recordSunkShip(Player* player, Coordinate coord, int size);
+bool popBestTarget(Player* bot, Fleet* opponentFleet, Coordinate* coord);
+Coordinate getSmokeScreenCoordinateForBot(Player* bot, Player* opponent);
+void deriveFleetView(char grid[GRID_SIZE][GRID_SIZE], Fleet* fleet);
+void updateThreatMap(Player* bot, Player* opponent);
+void addThreatExposure(ThreatMap* threat, int x, int y, int amount);
 void handleEdgeCoordinates(int* start, int* end);
-
-int main() {
+void gamePrintf(const char* format, ...);
+void waitForEnter();
+void initializeFleet(Fleet* fleet);
+bool simulateGame(DifficultyLevel first, DifficultyLevel second,
+                  const BotParams* firstParams, const BotParams* secondParams, GameResult* result);
+void initializeGameStats(GameStats* stats);
+void recordGameResult(GameStats* stats, const GameResult* result);
+void mergeGameStats(GameStats* into, const GameStats* from);
+int turnsQuantile(const GameStats* stats, double q);
+void printGameStats(const GameStats* stats);
+void runSimulations(long long games, DifficultyLevel first, DifficultyLevel second);
+DifficultyLevel parseDifficulty(const char* input, DifficultyLevel fallback);
+void recordPlacement(Fleet* fleet);
+void locateShips(char grid[GRID_SIZE][GRID_SIZE], Fleet* fleet);
+bool initializeGameStore(GameStore* store, int capacity);
+void freeGameStore(GameStore* store);
+Bitboard shipPlacementMask(unsigned char placement, int size);
+void refillBatchLane(GameStore* store, BatchScratch* scratch, int lane, int sideToMove);
+void batchTurn(GameStore* store, BatchScratch* scratch, int side);
+void batchLiveRow(unsigned short* restrict live, const unsigned short* restrict shots,
+                  const unsigned short* restrict ships, const unsigned short* restrict sunk);
+void batchCandidateRow(unsigned short* restrict candidates, unsigned short* restrict targetAny,
+                       unsigned short* restrict huntAny, const unsigned short* restrict shots,
+                       const unsigned short* restrict above, const unsigned short* restrict live,
+                       const unsigned short* restrict below, unsigned short parity);
+void batchHuntRow(unsigned short* restrict candidates, const unsigned short* restrict shots,
+                  const unsigned short* restrict targetAny, const unsigned short* restrict huntAny,
+                  unsigned short parity);
+void batchRemainingRow(unsigned short* restrict remaining, const unsigned short* restrict ship,
+                       const unsigned short* restrict shots);
+void batchSunkRow(unsigned short* restrict sunkRows, const unsigned short* restrict ship,
+                  const unsigned short* restrict sunkMask);
+void finishBatchLane(GameStore* store, BatchScratch* scratch, int lane, int winner, GameStats* stats);
+void* batchSimulationThread(void* arg);
+void runBatchSimulation(long long games);
+int formatPosition(Player* players[2], Fleet* fleets[2], int toMove, bool hardMode, char* text);
+void recordPosition(Player* players[2], Fleet* fleets[2], int toMove, bool hardMode);
+const char* parseGridField(const char* text, const char* end, char cells[GRID_SIZE][GRID_SIZE]);
+const char* parseSideField(const char* text, const char* end, Player* player);
+bool parsePosition(const char* text, size_t length, Position* position);
+bool loadPositionSuite(const char* path, PositionSuite* suite);
+size_t positionLength(const PositionSuite* suite, size_t index);
+void benchmarkPositions(const char* path);
+int bitboardCount(Bitboard board);
+Bitboard bitboardAnd(Bitboard a, Bitboard b);
+bool bitboardEmpty(Bitboard board);
+Bitboard cellMask(char grid[GRID_SIZE][GRID_SIZE], char low, char high);
+Bitboard windowFootprint(Coordinate anchor);
+Bitboard windowAny(Bitboard mask);
+WindowCounts windowCount(Bitboard mask);
+int windowCountAt(const WindowCounts* counts, int x, int y);
+void initializeGridKernels();
+void matchMaskScalar(const char* cells, char match, unsigned long long mask[CELL_MASK_WORDS]);
+int maskedArgmaxScalar(const int* values, const unsigned long long mask[CELL_MASK_WORDS], int* ties, int* tieCount);
+bool anyCellMatches(char grid[GRID_SIZE][GRID_SIZE], char match);
+void countCellsPerLine(char grid[GRID_SIZE][GRID_SIZE], char match, int rowCounts[GRID_SIZE], int columnCounts[GRID_SIZE]);
+int argmaxMatchingCells(int values[GRID_SIZE][GRID_SIZE], char grid[GRID_SIZE][GRID_SIZE], char match, int* ties, int* tieCount);
+bool learnPlacementPrior(const char* corpusPath, const char* priorPath);
+bool loadPlacementPrior(const char* path);
+int placementWeight(int shipIdx, char orientation, int x, int y);
+double currentTimeMs();
+bool searchBudgetLeft(double deadline, int done, int headlessQuota);
+int* botParamField(BotParams* params, const TunedParam* param);
+int collectTunedParams(DifficultyLevel difficulty, TunedParam* params);
+double evaluateBotParams(const BotParams* candidate, DifficultyLevel difficulty, int games);
+void evaluateGeneration(const BotParams candidates[TUNE_POPULATION], DifficultyLevel difficulty, int games,
+                        double scores[TUNE_POPULATION]);
+void tuneBotParams(int generations, int gamesPerCandidate, DifficultyLevel difficulty);
+double randomNormal();
+void initializeZobristKeys();
+unsigned long long hashDensityState(Player* bot, Fleet* opponentFleet, int symmetry);
+Coordinate transformCoordinate(Coordinate coord, int symmetry);
+int inverseSymmetry(int symmetry);
+bool preservesCheckerboard(int symmetry);
+void transformDensity(int density[GRID_SIZE][GRID_SIZE], int result[GRID_SIZE][GRID_SIZE], int symmetry);
+int canonicalizeDensityState(Player* bot, Fleet* opponentFleet, unsigned long long* key);
+unsigned long long densityChecksum(int density[GRID_SIZE][GRID_SIZE]);
+bool probeTranspositionTable(unsigned long long key, int density[GRID_SIZE][GRID_SIZE]);
+void storeTranspositionTable(unsigned long long key, int density[GRID_SIZE][GRID_SIZE]);
+void printTranspositionStats();
+double squareRoot(double value);
+void placeShipsRandomly(char grid[GRID_SIZE][GRID_SIZE], Fleet* fleet);
+void placeShipsOneByOne(char grid[GRID_SIZE][GRID_SIZE], Fleet* fleet);
+int countShotsToFind(char grid[GRID_SIZE][GRID_SIZE], Fleet* fleet);
+void placeShipsAdversarial(Player* bot, Fleet* fleet, double budgetMs);
+const void* mapReadOnlyFile(const char* path, size_t* size);
+void unmapReadOnlyFile(const void* data, size_t size);
+unsigned long long hashTrackingGrid(char trackingGrid[GRID_SIZE][GRID_SIZE], int symmetry);
+int canonicalTrackingSymmetry(char trackingGrid[GRID_SIZE][GRID_SIZE], unsigned long long* key);
+void expandOpeningNode(char trackingGrid[GRID_SIZE][GRID_SIZE], int depth, int samples,
+                       OpeningEntry* entries, int* count, int capacity);
+bool buildOpeningBook(int depth, int samples, const char* path);
+int compareOpeningEntries(const void* a, const void* b);
+bool loadOpeningBook(const char* path);
+bool openingBookApplies(Player* bot, Fleet* opponentFleet);
+bool lookupOpeningMove(char trackingGrid[GRID_SIZE][GRID_SIZE], Coordinate* coord);
+
+const Ship defaultShips[SHIP_TYPES] = {
+    {"Carrier", 5, 0, false, 'C', {0, 0}, 'h'},
+    {"Battleship", 4, 0, false, 'B', {0, 0}, 'h'},
+    {"Destroyer", 3, 0, false, 'D', {0, 0}, 'h'},
+    {"Submarine", 2, 0, false, 'S', {0, 0}, 'h'}
+};
+
+const BotParams defaultBotParams = {
+    10, 1, 1, 10,
+    { 0, 50, 50 },   // Radar
+    { 0, 35, 100 },  // Artillery
+    { 0, 30, 100 },  // Torpedo
+    { 0, 30, 100 }   // Smoke
+};
+
+// Zobrist keys: one per cell state ('o' and '*'; '~' hashes to zero), sunk ship and density parameter bit
+unsigned long long zobristCells[GRID_SIZE * GRID_SIZE][2];
+unsigned long long zobristSunk[SHIP_TYPES];
+unsigned long long zobristParams[3][64];
+bool zobristReady = false;
+
+// symmetryCells[s][cell] is the cell index that cell maps to under symmetry s
+int symmetryCells[SYMMETRIES][GRID_SIZE * GRID_SIZE];
+
+TranspositionTable transpositionTable;
+
+// Opening book mapped from OPENING_BOOK_FILE: sorted canonical keys and the matching canonical cells
+const unsigned long long* openingKeys = NULL;
+const unsigned char* openingCells = NULL;
+unsigned int openingCount = 0;
+
+bool quietMode = false; // Set by headless simulations to silence game output and pauses
+bool headlessGame = false; // Set by simulateGame: no wall-clock budgets, so runs are fast and repeatable
+double hardMoveBudgetMs = HARD_MOVE_BUDGET_MS; // 0 turns the anytime search off
+PonderState ponder;
+int particleCapacity = PARTICLE_COUNT; // Per filter; 0 samples every HARD move from scratch
+ParticleFilter particleFilters[MAX_PARTICLE_FILTERS];
+unsigned long long particleClock = 0;
+bool analysisEnabled = false; // Interactive games are recorded and analysed once they end
+GameRecord gameRecord;
+Journal journal = { -1, 1, 0, 0.0 };
+JournalSession journalSession;
+const char* journalPath = JOURNAL_FILE;
+SpectatorChannel* spectatorChannel = NULL; // Mapped read-write while this process broadcasts
+int spectatorLockFd = -1; // Kept open while broadcasting: its exclusive lock makes this the only producer
+Player* broadcastPlayers[2];
+FILE* positionLog = NULL; // Simulated games append the position before every move while set
+int salvoShots = 0; // Shots per turn: 0 for the classic single shot, SALVO_PER_SHIP or a fixed count
+
+unsigned char batchRowBits[1 << GRID_SIZE]; // Set bits of every row mask, filled before batch workers start
+GridKernels gridKernels;
+bool gridKernelsReady = false;
+
+// Learned placement prior: [ship][orientation][y][x], NULL when every placement is equally likely
+const unsigned short* placementPrior = NULL;
+
+int main(int argc, char* argv[]) {
     srand((unsigned int)time(NULL));
+
+    loadPlacementPrior(PLACEMENT_PRIOR_FILE);
+    loadOpeningBook(OPENING_BOOK_FILE);
+
+    // Prefixes for any mode: battleship --move-budget <ms> ... (HARD deadline, 0 = rule-based HARD bot)
+    // battleship --analyze ... (post-game analysis report after an interactive game) and
+    // battleship --journal <file> ... (journal file; headless simulations are journaled only with it)
+    // and battleship --broadcast ... (publish interactive games to --spectate viewers)
+    // and battleship --particles <n> ... (HARD bot's particle population, 0 = resample every move)
+    // and battleship --record-positions <file> ... (simulations append each position to the file)
+    // and battleship --salvo <shots|ships> ... (salvo rules: a fixed number of shots a turn, or one per ship afloat)
+    while (argc >= 2) {
+        if (argc >= 3 && strcmp(argv[1], "--move-budget") == 0) {
+            hardMoveBudgetMs = atof(argv[2]);
+            argv[2] = argv[0];
+            argc -= 2;
+            argv += 2;
+        } else if (argc >= 3 && strcmp(argv[1], "--particles") == 0) {
+            particleCapacity = atoi(argv[2]);
+            if (particleCapacity < 0) particleCapacity = 0;
+            if (particleCapacity > MAX_PARTICLES) particleCapacity = MAX_PARTICLES;
+            argv[2] = argv[0];
+            argc -= 2;
+            argv += 2;
+        } else if (argc >= 3 && strcmp(argv[1], "--salvo") == 0) {
+            salvoShots = strcmp(argv[2], "ships") == 0 ? SALVO_PER_SHIP : atoi(argv[2]);
+            if (salvoShots < SALVO_PER_SHIP) salvoShots = 0;
+            if (salvoShots > MAX_SALVO_SHOTS) salvoShots = MAX_SALVO_SHOTS;
+            argv[2] = argv[0];
+            argc -= 2;
+            argv += 2;
+        } else if (argc >= 3 && strcmp(argv[1], "--journal") == 0) {
+            journalPath = argv[2];
+            openJournal(journalPath);
+            argv[2] = argv[0];
+            argc -= 2;
+            argv += 2;
+        } else if (argc >= 3 && strcmp(argv[1], "--record-positions") == 0) {
+            positionLog = fopen(argv[2], "a");
+            if (!positionLog) printf("Could not open position log %s.\n", argv[2]);
+            argv[2] = argv[0];
+            argc -= 2;
+            argv += 2;
+        } else if (strcmp(argv[1], "--analyze") == 0) {
+            analysisEnabled = true;
+            argv[1] = argv[0];
+            argc--;
+            argv++;
+        } else if (strcmp(argv[1], "--broadcast") == 0) {
+            if (!openSpectatorChannel()) printf("Could not open spectator channel %s.\n", SPECTATOR_CHANNEL);
+            argv[1] = argv[0];
+            argc--;
+            argv++;
+        } else {
+            break;
+        }
+    }
+
+    // Headless mode: battleship --simulate <games> [first difficulty] [second difficulty]
+    if (argc >= 3 && strcmp(argv[1], "--simulate") == 0) {
+        long long games = atoll(argv[2]);
+        DifficultyLevel first = argc >= 4 ? parseDifficulty(argv[3], MEDIUM) : MEDIUM;
+        DifficultyLevel second = argc >= 5 ? parseDifficulty(argv[4], first) : first;
+        runSimulations(games, first, second);
+        return 0;
+    }
+
+    // Headless mode: battleship --batch-simulate <games> (lockstep bitboard hunter, no special moves)
+    if (argc >= 3 && strcmp(argv[1], "--batch-simulate") == 0) {
+        runBatchSimulation(atoll(argv[2]));
+        return 0;
+    }
+
+    // Viewer: battleship --spectate (follows the game broadcast on this machine)
+    if (argc >= 2 && strcmp(argv[1], "--spectate") == 0) {
+        spectate();
+        return 0;
+    }
+
+    // Crash recovery: battleship --resume <session> (replays the journal and continues the game)
+    if (argc >= 3 && strcmp(argv[1], "--resume") == 0) {
+        return resumeSession((unsigned int)strtoul(argv[2], NULL, 10), journalPath) ? 0 : 1;
+    }
+
+    // Offline step: battleship --learn-prior [corpus] [prior table]
+    if (argc >= 2 && strcmp(argv[1], "--learn-prior") == 0) {
+        const char* corpusPath = argc >= 3 ? argv[2] : PLACEMENT_CORPUS_FILE;
+        const char* priorPath = argc >= 4 ? argv[3] : PLACEMENT_PRIOR_FILE;
+        return learnPlacementPrior(corpusPath, priorPath) ? 0 : 1;
+    }
+
+    // Offline step: battleship --tune [generations] [games per candidate] [difficulty]
+    if (argc >= 2 && strcmp(argv[1], "--tune") == 0) {
+        int generations = argc >= 3 ? atoi(argv[2]) : 20;
+        int games = argc >= 4 ? atoi(argv[3]) : 400;
+        DifficultyLevel difficulty = argc >= 5 ? parseDifficulty(argv[4], MEDIUM) : MEDIUM;
+        tuneBotParams(generations, games, difficulty);
+        return 0;
+    }
+
+    // Offline step: battleship --bench-positions <file> (timings and a regression checksum per suite)
+    if (argc >= 3 && strcmp(argv[1], "--bench-positions") == 0) {
+        benchmarkPositions(argv[2]);
+        return 0;
+    }
+
+    // Offline step: battleship --build-openings [depth] [samples] [book file]
+    if (argc >= 2 && strcmp(argv[1], "--build-openings") == 0) {
+        int depth = argc >= 3 ? atoi(argv[2]) : OPENING_BOOK_DEPTH;
+        int samples = argc >= 4 ? atoi(argv[3]) : OPENING_BOOK_SAMPLES;
+        const char* path = argc >= 5 ? argv[4] : OPENING_BOOK_FILE;
+        return buildOpeningBook(depth, samples, path) ? 0 : 1;
+    }
+
     Player player1, botPlayer;
     Fleet fleet1, fleet2;
     bool hardMode = false;
@@ -148,20 +967,17 @@ int main() {
 
     printf("%s will play first.\n", currentPlayer->name);
 
-    const Ship defaultShips[SHIP_TYPES] = {
-        {"Carrier", 5, 0, false, 'C'},
-        {"Battleship", 4, 0, false, 'B'},
-        {"Destroyer", 3, 0, false, 'D'},
-        {"Submarine", 2, 0, false, 'S'}
-    };
-    memcpy(fleet1.ships, defaultShips, sizeof(defaultShips));
-    memcpy(fleet2.ships, defaultShips, sizeof(defaultShips));
+    initializeFleet(&fleet1);
+    initializeFleet(&fleet2);
 
     placeShips(&player1, &fleet1);
     clearScreen();
     placeShipsBot(&botPlayer, &fleet2);
     clearScreen();
 
+    if (journal.fd < 0 && !openJournal(journalPath)) {
+        printf("Could not open journal %s; this game cannot be resumed.\n", journalPath);
+    }
     gameLoop(currentPlayer, opponent, currentFleet, opponentFleet, hardMode);
 
     return 0;
@@ -177,12 +993,21 @@ void initializePlayer(Player* player, bool isBot, DifficultyLevel difficulty) {
     player->artilleryAvailable = false;
     player->torpedoAvailable = false;
     player->isBot = isBot;
-    player->potentialTargetCount = 0;
+    initializeTargetQueue(&player->potentialTargets);
+    memset(&player->resolvedHits, 0, sizeof(player->resolvedHits));
+    player->pendingSinkCount = 0;
+    player->threat.valid = false;
+    memset(&player->radarContacts, 0, sizeof(player->radarContacts));
+    memset(&player->radarClear, 0, sizeof(player->radarClear));
+    memset(&player->shotHistory, 0, sizeof(player->shotHistory));
     player->lastArtilleryHits = 0;
     player->lastArtilleryCoord.x = -1;
     player->lastArtilleryCoord.y = -1;
     player->difficulty = difficulty;
     player->turnNumber = 0; // Initialize turn number
+    player->artilleryUsed = 0;
+    player->torpedoUsed = 0;
+    player->params = &defaultBotParams;
     for (int i = 0; i < SHIP_TYPES; i++) {
         player->smokeScreens[i].active = false;
     }
@@ -264,19 +1089,77 @@ void placeShips(Player* player, Fleet* fleet) {
             }
         }
     }
+
+    locateShips(player->grid, fleet);
+    recordPlacement(fleet);
 }
 
+// HARD hides its fleet from the density hunter in interactive games only; a headless game would
+// spend the whole search budget before its first move
 void placeShipsBot(Player* bot, Fleet* fleet) {
+    if (bot->difficulty == HARD && !headlessGame) {
+        placeShipsAdversarial(bot, fleet, PLACEMENT_SEARCH_MS);
+    } else {
+        placeShipsRandomly(bot->grid, fleet);
+    }
+    locateShips(bot->grid, fleet);
+}
+
+// Places the fleet uniformly at random among all legal layouts, around anything already on the grid.
+// The tables for an empty board are built once; a partly filled grid gets its own. Should the
+// sampler find no layout, the ships are placed one at a time instead.
+void placeShipsRandomly(char grid[GRID_SIZE][GRID_SIZE], Fleet* fleet) {
+    static FleetSampler emptyBoard;
+    static bool emptyBoardReady = false;
+    static FleetSampler partlyFilled;
+
+    FleetConstraints constraints;
+    memset(&constraints, 0, sizeof(constraints));
+    Bitboard open = cellMask(grid, '~', '~');
+    for (int y = 0; y < GRID_SIZE; y++) constraints.mustNot.rows[y] = FULL_ROW & (unsigned short)~open.rows[y];
+
+    const FleetSampler* sampler = &emptyBoard;
+    bool ready;
+    if (!bitboardEmpty(constraints.mustNot)) {
+        ready = initializeFleetSampler(&partlyFilled, fleet, &constraints);
+        sampler = &partlyFilled;
+    } else {
+        if (!emptyBoardReady) emptyBoardReady = initializeFleetSampler(&emptyBoard, fleet, &constraints);
+        ready = emptyBoardReady;
+    }
+
+    unsigned int rng = (unsigned int)rand() * 2654435761u | 1;
+    int picks[SHIP_TYPES];
+    if (!ready || !sampleFleet(sampler, &rng, picks, 1 << 20)) {
+        placeShipsOneByOne(grid, fleet);
+        return;
+    }
     for (int i = 0; i < SHIP_TYPES; i++) {
-        bool placed = false;
-        while (!placed) {
-            Coordinate coord = getRandomCoordinate();
-            char orientation = (rand() % 2 == 0) ? 'h' : 'v';
-            if (isValidPlacement(bot->grid, coord, fleet->ships[i].size, orientation)) {
-                placeShipOnGrid(bot->grid, coord, fleet->ships[i].size, orientation, fleet->ships[i].symbol);
-                placed = true;
-            }
+        if (picks[i] < 0) continue;
+        unsigned char placement = sampler->placements[i][picks[i]];
+        Coordinate coord = { (placement & 0x7F) % GRID_SIZE, (placement & 0x7F) / GRID_SIZE };
+        placeShipOnGrid(grid, coord, fleet->ships[i].size, (placement & 0x80) ? 'v' : 'h', fleet->ships[i].symbol);
+    }
+}
+
+// Fallback placement: each ship in turn at a random spot among those still free. Not uniform over
+// whole fleets, but it only gives up when a ship has no free spot at all, and says so.
+void placeShipsOneByOne(char grid[GRID_SIZE][GRID_SIZE], Fleet* fleet) {
+    for (int i = 0; i < SHIP_TYPES; i++) {
+        unsigned char spots[2 * GRID_SIZE * GRID_SIZE];
+        int count = 0;
+        for (int cell = 0; cell < GRID_SIZE * GRID_SIZE; cell++) {
+            Coordinate coord = { cell % GRID_SIZE, cell / GRID_SIZE };
+            if (isValidPlacement(grid, coord, fleet->ships[i].size, 'h')) spots[count++] = (unsigned char)cell;
+            if (isValidPlacement(grid, coord, fleet->ships[i].size, 'v')) spots[count++] = (unsigned char)(cell | 0x80);
         }
+        if (count == 0) {
+            printf("No room left on the board for the %s.\n", fleet->ships[i].name);
+            return;
+        }
+        unsigned char spot = spots[rand() % count];
+        Coordinate coord = { (spot & 0x7F) % GRID_SIZE, (spot & 0x7F) / GRID_SIZE };
+        placeShipOnGrid(grid, coord, fleet->ships[i].size, (spot & 0x80) ? 'v' : 'h', fleet->ships[i].symbol);
     }
 }
 
@@ -336,6 +1219,7 @@ Coordinate parseCoordinate(const char* input) {
 }
 
 void clearScreen() {
+    if (quietMode) return;
 #ifdef _WIN32
     system("cls");
 #else
@@ -344,15 +1228,29 @@ void clearScreen() {
 }
 
 void gameLoop(Player* currentPlayer, Player* opponent, Fleet* currentFleet, Fleet* opponentFleet, bool hardMode) {
+    if (analysisEnabled && !gameRecord.active) startGameRecord(currentPlayer, opponent, currentFleet, opponentFleet);
+    if (!journalSession.open) {
+        beginJournalSession(&journalSession, currentPlayer, opponent, currentFleet, opponentFleet, hardMode);
+        if (journalSession.open) printf("Journaling this game as session %u.\n", journalSession.id);
+    }
+    beginBroadcast(currentPlayer, opponent);
+
     while (true) {
         if (currentPlayer->isBot) {
             performBotMove(currentPlayer, opponent, opponentFleet, hardMode);
         } else {
+            // A bot opponent samples its next move while the human is at the prompt
+            if (opponent->isBot) startPondering(opponent, currentFleet);
+            commitJournal(); // Nothing waits on the disk while the human thinks
             performMove(currentPlayer, opponent, opponentFleet, hardMode);
+            stopPondering();
         }
 
         if (checkWin(opponentFleet)) {
             printf("%s wins!\n", currentPlayer->name);
+            broadcastEvent(currentPlayer, SPECTATE_WIN, (Coordinate){ 0, 0 }, 0);
+            endJournalSession(&journalSession);
+            if (analysisEnabled) analyzeGame();
             break;
         }
 
@@ -375,17 +1273,22 @@ void performMove(Player* player, Player* opponent, Fleet* opponentFleet, bool ha
         printf("%s's turn.\n", player->name);
         displayTrackingGrid(player, hardMode);
         printf("Available moves:\n");
-        printf("1. Fire [coordinate]\n");
+        if (salvoShots != 0) {
+            printf("1. Fire [%d coordinates] (salvo)\n", salvoSize(player));
+        } else {
+            printf("1. Fire [coordinate]\n");
+        }
         printf("2. Radar [coordinate] (Used %d/%d)\n", player->radarSweepsUsed, MAX_RADAR_SWEEPS);
-        if (player->smokeScreensUsed < player->shipsSunk) {
+        if (isActionAvailable(player, ACTION_SMOKE)) {
             printf("3. Smoke [coordinate] (Used %d)\n", player->smokeScreensUsed);
         }
-        if (player->artilleryAvailable) {
+        if (isActionAvailable(player, ACTION_ARTILLERY)) {
             printf("4. Artillery [coordinate]\n");
         }
-        if (player->torpedoAvailable) {
+        if (isActionAvailable(player, ACTION_TORPEDO)) {
             printf("5. Torpedo [row/column]\n");
         }
+        printf("6. Hint (free, does not end your turn)\n");
         printf("Enter your move: ");
         getInput(input, sizeof(input));
         toLowerCase(input);
@@ -393,6 +1296,11 @@ void performMove(Player* player, Player* opponent, Fleet* opponentFleet, bool ha
         char* command = strtok(input, " ");
         char* argument = strtok(NULL, " ");
 
+        if (command && strcmp(command, "hint") == 0) {
+            showHint(player, opponentFleet);
+            continue;
+        }
+
         if (!command || !argument) {
             printf("Invalid input format.\n");
             return;
@@ -403,7 +1311,34 @@ void performMove(Player* player, Player* opponent, Fleet* opponentFleet, bool ha
             return;
         }
 
-        if (strcmp(command, "fire") == 0) {
+        if (strcmp(command, "fire") == 0 && salvoShots != 0) {
+            Coordinate shots[MAX_SALVO_SHOTS];
+            int count = salvoSize(player);
+            int given = 0;
+            for (char* token = argument; token; token = strtok(NULL, " ")) {
+                Coordinate coord = parseCoordinate(token);
+                if (coord.x == -1 || coord.y == -1) {
+                    printf("Invalid coordinates.\n");
+                    return;
+                }
+                for (int i = 0; i < given && i < count; i++) {
+                    if (shots[i].x == coord.x && shots[i].y == coord.y) {
+                        printf("Each shot of a salvo needs its own coordinate.\n");
+                        return;
+                    }
+                }
+                if (given < count) shots[given] = coord;
+                given++;
+            }
+            if (given != count) {
+                printf("This salvo is %d shots: fire followed by %d coordinates.\n", count, count);
+                return;
+            }
+            fireSalvo(player, opponent, opponentFleet, shots, count, hardMode);
+            validMove = true;
+            printf("Press Enter to continue...");
+            getchar();
+        } else if (strcmp(command, "fire") == 0) {
             Coordinate coord = parseCoordinate(argument);
             if (coord.x != -1 && coord.y != -1) {
                 char sunkShipName[20] = "";
@@ -426,20 +1361,15 @@ void performMove(Player* player, Player* opponent, Fleet* opponentFleet, bool ha
                 return;
             }
         } else if (strcmp(command, "radar") == 0) {
-            if (player->radarSweepsUsed < MAX_RADAR_SWEEPS) {
-                Coordinate coord = parseCoordinate(argument);
-                if (coord.x != -1 && coord.y != -1) {
-                    radarSweep(player, opponent, coord);
-                    player->radarSweepsUsed++;
-                    validMove = true;
-                    printf("Press Enter to continue...");
-                    getchar();
-                } else {
-                    printf("Invalid coordinates.\n");
-                    return;
-                }
+            Coordinate coord = parseCoordinate(argument);
+            if (coord.x != -1 && coord.y != -1) {
+                radarSweep(player, opponent, coord);
+                player->radarSweepsUsed++;
+                validMove = true;
+                printf("Press Enter to continue...");
+                getchar();
             } else {
-                printf("Radar sweeps limit reached.\n");
+                printf("Invalid coordinates.\n");
                 return;
             }
         } else if (strcmp(command, "smoke") == 0) {
@@ -484,7 +1414,7 @@ void performMove(Player* player, Player* opponent, Fleet* opponentFleet, bool ha
 }
 
 void performBotMove(Player* bot, Player* opponent, Fleet* opponentFleet, bool hardMode) {
-    printf("%s's turn.\n", bot->name);
+    gamePrintf("%s's turn.\n", bot->name);
 
     bot->turnNumber++; // Increment bot's turn number
 
@@ -498,18 +1428,19 @@ void performBotMove(Player* bot, Player* opponent, Fleet* opponentFleet, bool ha
         // FIRE is a priority
         // No targeting mode after a hit, unless radar has found enemy ships
 
-        // Radar is done at the 6-10th turn at every 10 turns
-        int turnInInterval = (bot->turnNumber - 1) % 10 + 1;
+        // Radar is done at the 6-10th turn at every 10 turns (cadence is a tunable parameter)
+        int cadence = bot->params->easyCadence;
+        int turnInInterval = (bot->turnNumber - 1) % cadence + 1;
 
         // Use Radar if allowed and available
-        if (!moveMade && bot->radarSweepsUsed < MAX_RADAR_SWEEPS &&
-            turnInInterval >= 6 && turnInInterval <= 10) {
+        if (!moveMade && isActionAvailable(bot, ACTION_RADAR) &&
+            turnInInterval >= cadence - 4 && turnInInterval <= cadence) {
 
             coord = getRandomCoordinate();
-            printf("%s uses Radar at ", bot->name);
+            gamePrintf("%s uses Radar at ", bot->name);
             char coordStr[5];
             coordinateToString(coord, coordStr);
-            printf("%s\n", coordStr);
+            gamePrintf("%s\n", coordStr);
             radarSweep(bot, opponent, coord);
             bot->radarSweepsUsed++;
             moveMade = true;
@@ -518,59 +1449,64 @@ void performBotMove(Player* bot, Player* opponent, Fleet* opponentFleet, bool ha
         }
 
         // Artillery is done only at the 7-10th turn at every 10 turns when it's available
-        if (!moveMade && bot->artilleryAvailable &&
-            turnInInterval >= 7 && turnInInterval <= 10) {
+        if (!moveMade && isActionAvailable(bot, ACTION_ARTILLERY) &&
+            turnInInterval >= cadence - 3 && turnInInterval <= cadence) {
 
             coord = getBestArtilleryTarget(bot);
-            printf("%s uses Artillery at ", bot->name);
+            gamePrintf("%s uses Artillery at ", bot->name);
             char coordStr[5];
             coordinateToString(coord, coordStr);
-            printf("%s\n", coordStr);
+            gamePrintf("%s\n", coordStr);
             artillery(bot, opponent, opponentFleet, coord, hardMode);
             bot->artilleryAvailable = false;
             moveMade = true;
         }
 
         // Smoke is at 10th turn at every 10 turns when it's available
-        if (!moveMade && bot->smokeScreensUsed < bot->shipsSunk &&
-            turnInInterval == 10) {
+        if (!moveMade && isActionAvailable(bot, ACTION_SMOKE) &&
+            turnInInterval == cadence) {
 
-            Coordinate smokeCoord = getSmokeScreenCoordinateForBot(bot);
+            Coordinate smokeCoord = getSmokeScreenCoordinateForBot(bot, opponent);
             if (smokeCoord.x != -1 && smokeCoord.y != -1 && smokeScreen(bot, smokeCoord)) {
-                printf("%s deployed a smoke screen.\n", bot->name);
+                gamePrintf("%s deployed a smoke screen.\n", bot->name);
                 moveMade = true;
             }
         }
 
         // Torpedo is done only at the 10-15th turn at every 15 turns when it's available
         int turnInInterval15 = (bot->turnNumber - 1) % 15 + 1;
-        if (!moveMade && bot->torpedoAvailable &&
+        if (!moveMade && isActionAvailable(bot, ACTION_TORPEDO) &&
             turnInInterval15 >= 10 && turnInInterval15 <= 15) {
 
             if (!chooseTorpedoTarget(bot, opponent, opponentFleet, hardMode)) {
                 // Fallback to fire if no valid torpedo target
                 coord = getNextTarget(bot, opponentFleet);
                 if (coord.x != -1 && coord.y != -1) {
-                    printf("%s fires at ", bot->name);
+                    gamePrintf("%s fires at ", bot->name);
                     char coordStr[5];
                     coordinateToString(coord, coordStr);
-                    printf("%s\n", coordStr);
+                    gamePrintf("%s\n", coordStr);
                     result = fire(bot, opponent, opponentFleet, coord, hardMode, sunkShipName);
                 } else {
-                    printf("%s has no valid targets to fire.\n", bot->name);
+                    gamePrintf("%s has no valid targets to fire.\n", bot->name);
                 }
             }
             bot->torpedoAvailable = false;
             moveMade = true;
         }
 
+        // Salvo rules: the shots of the turn are chosen together
+        if (!moveMade && salvoShots != 0) {
+            performBotSalvo(bot, opponent, opponentFleet, hardMode);
+            moveMade = true;
+        }
+
         // Targeting Mode after radar has found enemy ships
-        if (!moveMade && bot->potentialTargetCount > 0) {
-            coord = bot->potentialTargets[--bot->potentialTargetCount];
-            printf("%s fires at ", bot->name);
+        if (!moveMade && popBestTarget(bot, opponentFleet, &coord)) {
+            gamePrintf("%s fires at ", bot->name);
             char coordStr[5];
             coordinateToString(coord, coordStr);
-            printf("%s (Targeting mode)\n", coordStr);
+            gamePrintf("%s (Targeting mode)\n", coordStr);
             result = fire(bot, opponent, opponentFleet, coord, hardMode, sunkShipName);
             moveMade = true;
         }
@@ -579,91 +1515,86 @@ void performBotMove(Player* bot, Player* opponent, Fleet* opponentFleet, bool ha
         if (!moveMade) {
             coord = getNextTarget(bot, opponentFleet);
             if (coord.x != -1 && coord.y != -1) {
-                printf("%s fires at ", bot->name);
+                gamePrintf("%s fires at ", bot->name);
                 char coordStr[5];
                 coordinateToString(coord, coordStr);
-                printf("%s\n", coordStr);
+                gamePrintf("%s\n", coordStr);
                 result = fire(bot, opponent, opponentFleet, coord, hardMode, sunkShipName);
                 moveMade = true;
             } else {
-                printf("%s has no valid targets to fire.\n", bot->name);
+                gamePrintf("%s has no valid targets to fire.\n", bot->name);
             }
         }
 
         // Process fire result
         if (result != -1) {
             if (result == 0) {
-                printf("Miss!\n");
+                gamePrintf("Miss!\n");
             } else if (result == 1) {
-                printf("Hit!\n");
+                gamePrintf("Hit!\n");
                 // Do not add adjacent targets in EASY difficulty after a hit
             } else if (result == 2) {
-                printf("%s sunk your %s!\n", bot->name, sunkShipName);
-                bot->potentialTargetCount = 0;
+                gamePrintf("%s sunk your %s!\n", bot->name, sunkShipName);
                 unlockSpecialMoves(bot, opponent);
             } else if (result == 3) {
-                printf("Already targeted this coordinate.\n");
+                gamePrintf("Already targeted this coordinate.\n");
             }
         }
 
     } else {
-        // Determine move probabilities based on difficulty level
-        int radarChance, artilleryChance, torpedoChance, smokeChance;
-        switch (bot->difficulty) {
-            case MEDIUM:
-                radarChance = 50;
-                artilleryChance = 35;
-                torpedoChance = 30;
-                smokeChance = 30;
-                break;
-            case HARD:
-                radarChance = 50;
-                artilleryChance = 100; // Aggressive use
-                torpedoChance = 100;
-                smokeChance = 100;
-                break;
-            default:
-                radarChance = 0;
-                artilleryChance = 0;
-                torpedoChance = 0;
-                smokeChance = 0;
-                break;
-        }
+        // Determine move probabilities based on difficulty level (HARD uses specials aggressively)
+        int radarChance = bot->params->radarChance[bot->difficulty];
+        int artilleryChance = bot->params->artilleryChance[bot->difficulty];
+        int torpedoChance = bot->params->torpedoChance[bot->difficulty];
+        int smokeChance = bot->params->smokeChance[bot->difficulty];
 
         // Smoke Screen
-        if (bot->smokeScreensUsed < bot->shipsSunk && !moveMade && (rand() % 100) < smokeChance) {
-            Coordinate smokeCoord = getSmokeScreenCoordinateForBot(bot);
+        if (isActionAvailable(bot, ACTION_SMOKE) && !moveMade && (rand() % 100) < smokeChance) {
+            Coordinate smokeCoord = getSmokeScreenCoordinateForBot(bot, opponent);
             if (smokeCoord.x != -1 && smokeCoord.y != -1 && smokeScreen(bot, smokeCoord)) {
-                printf("%s deployed a smoke screen.\n", bot->name);
+                gamePrintf("%s deployed a smoke screen.\n", bot->name);
                 moveMade = true;
             }
         }
 
+        // HARD: anytime search over sampled layouts picks the shot, artillery anchor or torpedo line.
+        // Radar keeps its roll when no special is in hand, and the rules below remain the fallback
+        // whenever the search comes back empty-handed. Under salvo rules the salvo search below takes
+        // the single shot's place, and specials come from the rolls.
+        if (!moveMade && bot->difficulty == HARD && hardMoveBudgetMs > 0 && salvoShots == 0) {
+            double deadline = currentTimeMs() + hardMoveBudgetMs;
+            bool specialReady = bot->artilleryAvailable || bot->torpedoAvailable;
+            bool radarRoll = !specialReady && isActionAvailable(bot, ACTION_RADAR) && (rand() % 100) < radarChance;
+            if (!radarRoll) {
+                moveMade = performAnytimeMove(bot, opponent, opponentFleet, hardMode, deadline, &coord, &result, sunkShipName);
+            }
+        }
+
         // Artillery
-        if (bot->artilleryAvailable && !moveMade && (rand() % 100) < artilleryChance) {
+        if (isActionAvailable(bot, ACTION_ARTILLERY) && !moveMade && (rand() % 100) < artilleryChance) {
             coord = getBestArtilleryTarget(bot);
-            printf("%s uses Artillery at ", bot->name);
+            gamePrintf("%s uses Artillery at ", bot->name);
             char coordStr[5];
             coordinateToString(coord, coordStr);
-            printf("%s\n", coordStr);
+            gamePrintf("%s\n", coordStr);
             artillery(bot, opponent, opponentFleet, coord, hardMode);
             bot->artilleryAvailable = false;
             moveMade = true;
         }
 
         // Torpedo
-        if (bot->torpedoAvailable && !moveMade && (rand() % 100) < torpedoChance) {
+        if (isActionAvailable(bot, ACTION_TORPEDO) && !moveMade && (rand() % 100) < torpedoChance) {
             if (!chooseTorpedoTarget(bot, opponent, opponentFleet, hardMode)) {
                 // Fallback to fire if no valid torpedo target
                 coord = getNextTarget(bot, opponentFleet);
                 if (coord.x != -1 && coord.y != -1) {
-                    printf("%s fires at ", bot->name);
+                    gamePrintf("%s fires at ", bot->name);
                     char coordStr[5];
                     coordinateToString(coord, coordStr);
-                    printf("%s\n", coordStr);
+                    gamePrintf("%s\n", coordStr);
                     result = fire(bot, opponent, opponentFleet, coord, hardMode, sunkShipName);
                 } else {
-                    printf("%s has no valid targets to fire.\n", bot->name);
+                    gamePrintf("%s has no valid targets to fire.\n", bot->name);
                 }
             }
             bot->torpedoAvailable = false;
@@ -671,24 +1602,29 @@ void performBotMove(Player* bot, Player* opponent, Fleet* opponentFleet, bool ha
         }
 
         // Radar
-        if (!moveMade && bot->radarSweepsUsed < MAX_RADAR_SWEEPS && (rand() % 100) < radarChance) {
+        if (!moveMade && isActionAvailable(bot, ACTION_RADAR) && (rand() % 100) < radarChance) {
             coord = getRandomCoordinate();
-            printf("%s uses Radar at ", bot->name);
+            gamePrintf("%s uses Radar at ", bot->name);
             char coordStr[5];
             coordinateToString(coord, coordStr);
-            printf("%s\n", coordStr);
+            gamePrintf("%s\n", coordStr);
             radarSweep(bot, opponent, coord);
             bot->radarSweepsUsed++;
             moveMade = true;
         }
 
+        // Salvo rules: the shots of the turn are chosen together
+        if (!moveMade && salvoShots != 0) {
+            performBotSalvo(bot, opponent, opponentFleet, hardMode);
+            moveMade = true;
+        }
+
         // Targeting Mode
-        if (!moveMade && bot->potentialTargetCount > 0) {
-            coord = bot->potentialTargets[--bot->potentialTargetCount];
-            printf("%s fires at ", bot->name);
+        if (!moveMade && popBestTarget(bot, opponentFleet, &coord)) {
+            gamePrintf("%s fires at ", bot->name);
             char coordStr[5];
             coordinateToString(coord, coordStr);
-            printf("%s (Targeting mode)\n", coordStr);
+            gamePrintf("%s (Targeting mode)\n", coordStr);
             result = fire(bot, opponent, opponentFleet, coord, hardMode, sunkShipName);
             moveMade = true;
         }
@@ -697,47 +1633,53 @@ void performBotMove(Player* bot, Player* opponent, Fleet* opponentFleet, bool ha
         if (!moveMade) {
             coord = getNextTarget(bot, opponentFleet);
             if (coord.x != -1 && coord.y != -1) {
-                printf("%s fires at ", bot->name);
+                gamePrintf("%s fires at ", bot->name);
                 char coordStr[5];
                 coordinateToString(coord, coordStr);
-                printf("%s\n", coordStr);
+                gamePrintf("%s\n", coordStr);
                 result = fire(bot, opponent, opponentFleet, coord, hardMode, sunkShipName);
                 moveMade = true;
             } else {
-                printf("%s has no valid targets to fire.\n", bot->name);
+                gamePrintf("%s has no valid targets to fire.\n", bot->name);
             }
         }
 
         // Process fire result
         if (result != -1) {
             if (result == 0) {
-                printf("Miss!\n");
+                gamePrintf("Miss!\n");
             } else if (result == 1) {
-                printf("Hit!\n");
+                gamePrintf("Hit!\n");
                 addAdjacentTargets(bot, coord);
             } else if (result == 2) {
-                printf("%s sunk your %s!\n", bot->name, sunkShipName);
-                bot->potentialTargetCount = 0;
+                gamePrintf("%s sunk your %s!\n", bot->name, sunkShipName);
                 unlockSpecialMoves(bot, opponent);
             } else if (result == 3) {
-                printf("Already targeted this coordinate.\n");
+                gamePrintf("Already targeted this coordinate.\n");
             }
         }
     }
 
-    printf("Press Enter to continue...");
-    getchar();
+    waitForEnter();
 }
 
 int fire(Player* player, Player* opponent, Fleet* opponentFleet, Coordinate coord, bool hardMode, char* sunkShipName) {
+    int result = resolveShot(player, opponent, opponentFleet, coord, hardMode, sunkShipName);
+    logAction(player, ACTION_FIRE, coord.y * GRID_SIZE + coord.x, result == 1 || result == 2);
+    return result;
+}
 
+// One shot without logging it as an action; artillery and torpedo log their volley as a whole
+int resolveShot(Player* player, Player* opponent, Fleet* opponentFleet, Coordinate coord, bool hardMode, char* sunkShipName) {
     char cell = opponent->grid[coord.y][coord.x];
+    player->shotHistory.rows[coord.y] |= (unsigned short)(1 << coord.x);
 
     if (cell == '~') {
         opponent->grid[coord.y][coord.x] = 'o';
         if (!hardMode || player->isBot) {
             player->trackingGrid[coord.y][coord.x] = 'o';
         }
+        broadcastEvent(player, SPECTATE_MISS, coord, 0);
         return 0;
     } else if (cell >= 'A' && cell <= 'Z') {
         if (opponent->grid[coord.y][coord.x] == 'X') {
@@ -750,8 +1692,10 @@ int fire(Player* player, Player* opponent, Fleet* opponentFleet, Coordinate coor
             if (opponentFleet->ships[i].symbol == cell) {
                 opponentFleet->ships[i].hits++;
                 updateShipStatus(&opponentFleet->ships[i]);
+                broadcastEvent(player, opponentFleet->ships[i].sunk ? SPECTATE_SINK : SPECTATE_HIT, coord, i);
                 if (opponentFleet->ships[i].sunk) {
                     strcpy(sunkShipName, opponentFleet->ships[i].name);
+                    recordSunkShip(player, coord, opponentFleet->ships[i].size);
                     player->shipsSunk++;
                     opponent->shipsRemaining--;
                     return 2;
@@ -767,43 +1711,34 @@ int fire(Player* player, Player* opponent, Fleet* opponentFleet, Coordinate coor
 
 void radarSweep(Player* player, Player* opponent, Coordinate coord) {
     if (coord.x < 0 || coord.x >= GRID_SIZE || coord.y < 0 || coord.y >= GRID_SIZE) {
-        printf("Invalid coordinates for radar sweep.\n");
+        gamePrintf("Invalid coordinates for radar sweep.\n");
         return;
     }
 
-    int xStart = coord.x;
-    int yStart = coord.y;
-    int xEnd = coord.x + 1;
-    int yEnd = coord.y + 1;
-
-    handleEdgeCoordinates(&xStart, &xEnd);
-    handleEdgeCoordinates(&yStart, &yEnd);
+    Bitboard footprint = windowFootprint(coord);
 
     for (int i = 0; i < opponent->smokeScreensUsed; i++) {
         if (opponent->smokeScreens[i].active) {
-            Coordinate smokeCoord = opponent->smokeScreens[i].coord;
-            int sxStart = smokeCoord.x;
-            int syStart = smokeCoord.y;
-            int sxEnd = smokeCoord.x + 1;
-            int syEnd = smokeCoord.y + 1;
-
-            handleEdgeCoordinates(&sxStart, &sxEnd);
-            handleEdgeCoordinates(&syStart, &syEnd);
-
-            if (!(xEnd < sxStart || xStart > sxEnd || yEnd < syStart || yStart > syEnd)) {
-                printf("Radar sweep found no enemy ships (area obscured by smoke).\n");
+            Bitboard smoke = windowFootprint(opponent->smokeScreens[i].coord);
+            if (!bitboardEmpty(bitboardAnd(footprint, smoke))) {
+                gamePrintf("Radar sweep found no enemy ships (area obscured by smoke).\n");
                 opponent->smokeScreens[i].active = false;
+                logAction(player, ACTION_RADAR, coord.y * GRID_SIZE + coord.x, 2);
                 return;
             }
         }
     }
 
-    bool found = false;
-    for (int i = yStart; i <= yEnd; i++) {
-        for (int j = xStart; j <= xEnd; j++) {
-            if (opponent->grid[i][j] >= 'A' && opponent->grid[i][j] <= 'Z') {
-                found = true;
-                if (player->isBot) {
+    Bitboard contacts = bitboardAnd(footprint, cellMask(opponent->grid, 'A', 'Z'));
+    bool found = !bitboardEmpty(contacts);
+    for (int i = 0; i < GRID_SIZE; i++) {
+        player->radarContacts.rows[i] |= contacts.rows[i];
+        player->radarClear.rows[i] |= footprint.rows[i] & (unsigned short)~contacts.rows[i];
+    }
+    if (player->isBot) {
+        for (int i = 0; i < GRID_SIZE; i++) {
+            for (int j = 0; j < GRID_SIZE; j++) {
+                if ((contacts.rows[i] >> j) & 1) {
                     Coordinate targetCoord = { j, i };
                     addPotentialTarget(player, targetCoord);
                 }
@@ -811,28 +1746,30 @@ void radarSweep(Player* player, Player* opponent, Coordinate coord) {
         }
     }
 
+    logAction(player, ACTION_RADAR, coord.y * GRID_SIZE + coord.x, found);
     if (found) {
-        printf("Radar detected enemy ships near the target area.\n");
+        gamePrintf("Radar detected enemy ships near the target area.\n");
     } else {
-        printf("Radar sweep found no enemy ships.\n");
+        gamePrintf("Radar sweep found no enemy ships.\n");
     }
 }
 
 bool smokeScreen(Player* player, Coordinate coord) {
     if (coord.x < 0 || coord.x >= GRID_SIZE || coord.y < 0 || coord.y >= GRID_SIZE) {
-        printf("Invalid coordinates. Smoke screen not deployed.\n");
+        gamePrintf("Invalid coordinates. Smoke screen not deployed.\n");
         return false;
     }
 
-    if (player->smokeScreensUsed >= player->shipsSunk) {
-        printf("No smoke screens available. You must sink more ships to use another smoke screen.\n");
+    if (!isActionAvailable(player, ACTION_SMOKE)) {
+        gamePrintf("No smoke screens available. You must sink more ships to use another smoke screen.\n");
         return false;
     }
 
     player->smokeScreens[player->smokeScreensUsed].coord = coord;
     player->smokeScreens[player->smokeScreensUsed].active = true;
     player->smokeScreensUsed++;
-    printf("Smoke screen deployed.\n");
+    logAction(player, ACTION_SMOKE, coord.y * GRID_SIZE + coord.x, 0);
+    gamePrintf("Smoke screen deployed.\n");
     clearScreen();
     return true;
 }
@@ -843,20 +1780,15 @@ void artillery(Player* player, Player* opponent, Fleet* opponentFleet, Coordinat
     char sunkShips[SHIP_TYPES][20] = { "" };
     int sunkShipsCount = 0;
 
-    int xStart = coord.x;
-    int yStart = coord.y;
-    int xEnd = coord.x + 1;
-    int yEnd = coord.y + 1;
-
-    handleEdgeCoordinates(&xStart, &xEnd);
-    handleEdgeCoordinates(&yStart, &yEnd);
+    Bitboard footprint = windowFootprint(coord);
 
-    printf("Artillery strike results at %c%d:\n", 'A' + coord.x, coord.y + 1);
-    for (int i = yStart; i <= yEnd; i++) {
-        for (int j = xStart; j <= xEnd; j++) {
+    gamePrintf("Artillery strike results at %c%d:\n", 'A' + coord.x, coord.y + 1);
+    for (int i = 0; i < GRID_SIZE; i++) {
+        for (int j = 0; j < GRID_SIZE; j++) {
+            if (!((footprint.rows[i] >> j) & 1)) continue;
             Coordinate tempCoord = { j, i };
             char sunkShipName[20] = "";
-            int result = fire(player, opponent, opponentFleet, tempCoord, hardMode, sunkShipName);
+            int result = resolveShot(player, opponent, opponentFleet, tempCoord, hardMode, sunkShipName);
             if (result == 0) {
                 totalMisses++;
             } else if (result == 1) {
@@ -873,14 +1805,16 @@ void artillery(Player* player, Player* opponent, Fleet* opponentFleet, Coordinat
         player->lastArtilleryCoord = coord;
     }
 
-    printf("Total Hits: %d\nTotal Misses: %d\n", totalHits, totalMisses);
+    player->artilleryUsed++;
+    logAction(player, ACTION_ARTILLERY, coord.y * GRID_SIZE + coord.x, totalHits);
+    gamePrintf("Total Hits: %d\nTotal Misses: %d\n", totalHits, totalMisses);
 
     if (sunkShipsCount > 0) {
         for (int i = 0; i < sunkShipsCount; i++) {
             if (player->isBot) {
-                printf("%s sunk your %s!\n", player->name, sunkShips[i]);
+                gamePrintf("%s sunk your %s!\n", player->name, sunkShips[i]);
             } else {
-                printf("You sunk the opponent's %s!\n", sunkShips[i]);
+                gamePrintf("You sunk the opponent's %s!\n", sunkShips[i]);
             }
         }
         unlockSpecialMoves(player, opponent);
@@ -892,20 +1826,22 @@ void torpedo(Player* player, Player* opponent, Fleet* opponentFleet, const char*
     int totalMisses = 0;
     char sunkShips[SHIP_TYPES][20] = { "" };
     int sunkShipsCount = 0;
+    int line;
 
-    printf("Torpedo attack results on %s:\n", isalpha(input[0]) ? "column" : "row");
+    gamePrintf("Torpedo attack results on %s:\n", isalpha(input[0]) ? "column" : "row");
 
     if (isalpha(input[0])) {
         int col = tolower(input[0]) - 'a';
         if (col < 0 || col >= GRID_SIZE) {
-            printf("Invalid column.\n");
+            gamePrintf("Invalid column.\n");
             return;
         }
-        printf("Torpedoing column %c:\n", 'A' + col);
+        gamePrintf("Torpedoing column %c:\n", 'A' + col);
+        line = GRID_SIZE + col;
         for (int i = 0; i < GRID_SIZE; i++) {
             Coordinate coord = { col, i };
             char sunkShipName[20] = "";
-            int result = fire(player, opponent, opponentFleet, coord, hardMode, sunkShipName);
+            int result = resolveShot(player, opponent, opponentFleet, coord, hardMode, sunkShipName);
             if (result == 0) {
                 totalMisses++;
             } else if (result == 1) {
@@ -918,14 +1854,15 @@ void torpedo(Player* player, Player* opponent, Fleet* opponentFleet, const char*
     } else {
         int row = atoi(input) - 1;
         if (row < 0 || row >= GRID_SIZE) {
-            printf("Invalid row.\n");
+            gamePrintf("Invalid row.\n");
             return;
         }
-        printf("Torpedoing row %d:\n", row + 1);
+        gamePrintf("Torpedoing row %d:\n", row + 1);
+        line = row;
         for (int i = 0; i < GRID_SIZE; i++) {
             Coordinate coord = { i, row };
             char sunkShipName[20] = "";
-            int result = fire(player, opponent, opponentFleet, coord, hardMode, sunkShipName);
+            int result = resolveShot(player, opponent, opponentFleet, coord, hardMode, sunkShipName);
             if (result == 0) {
                 totalMisses++;
             } else if (result == 1) {
@@ -937,14 +1874,16 @@ void torpedo(Player* player, Player* opponent, Fleet* opponentFleet, const char*
         }
     }
 
-    printf("Total Hits: %d\nTotal Misses: %d\n", totalHits, totalMisses);
+    player->torpedoUsed++;
+    logAction(player, ACTION_TORPEDO, line, totalHits);
+    gamePrintf("Total Hits: %d\nTotal Misses: %d\n", totalHits, totalMisses);
 
     if (sunkShipsCount > 0) {
         for (int i = 0; i < sunkShipsCount; i++) {
             if (player->isBot) {
-                printf("%s sunk your %s!\n", player->name, sunkShips[i]);
+                gamePrintf("%s sunk your %s!\n", player->name, sunkShips[i]);
             } else {
-                printf("You sunk the opponent's %s!\n", sunkShips[i]);
+                gamePrintf("You sunk the opponent's %s!\n", sunkShips[i]);
             }
         }
         unlockSpecialMoves(player, opponent);
@@ -974,23 +1913,23 @@ void unlockSpecialMoves(Player* player, Player* opponent) {
     if (!player->artilleryAvailable) {
         player->artilleryAvailable = true;
         if (player->isBot) {
-            printf("%s has unlocked Artillery for the next turn!\n", player->name);
+            gamePrintf("%s has unlocked Artillery for the next turn!\n", player->name);
         } else {
-            printf("Artillery will be available for your next turn!\n");
+            gamePrintf("Artillery will be available for your next turn!\n");
         }
     }
 
     if (opponent->shipsRemaining == 1 && !player->torpedoAvailable) {
         player->torpedoAvailable = true;
         if (player->isBot) {
-            printf("%s has unlocked Torpedo for the next turn!\n", player->name);
+            gamePrintf("%s has unlocked Torpedo for the next turn!\n", player->name);
         } else {
-            printf("Torpedo will be available for your next turn!\n");
+            gamePrintf("Torpedo will be available for your next turn!\n");
         }
     }
 
     if (player->shipsSunk > player->smokeScreensUsed && player->smokeScreensUsed < SHIP_TYPES) {
-        printf("%s has unlocked a Smoke Screen for the next turn!\n", player->name);
+        gamePrintf("%s has unlocked a Smoke Screen for the next turn!\n", player->name);
     }
 }
 
@@ -999,22 +1938,149 @@ void displayTrackingGrid(Player* player, bool hardMode) {
     displayGrid(player->trackingGrid, !hardMode);
 }
 
-bool isValidCommand(const char* command, Player* player) {
-    if (strcmp(command, "fire") == 0 || strcmp(command, "radar") == 0) {
-        return true;
+// Runs the bot's density engine on the player's own knowledge and suggests a move. In hardMode the
+// tracking grid does not show misses, so they are restored from the shot history for the computation. The density
+// comes from the transposition table, so a repeated or mirrored position costs a lookup.
+void showHint(Player* player, Fleet* opponentFleet) {
+    static Player view; // Same knowledge, but with every miss on the grid
+    view = *player;
+    for (int y = 0; y < GRID_SIZE; y++) {
+        for (int x = 0; x < GRID_SIZE; x++) {
+            if (((player->shotHistory.rows[y] >> x) & 1) && view.trackingGrid[y][x] == '~') {
+                view.trackingGrid[y][x] = 'o';
+            }
+        }
     }
-    if (strcmp(command, "smoke") == 0 && player->smokeScreensUsed < player->shipsSunk) {
-        return true;
+    view.params = &defaultBotParams;
+
+    int density[GRID_SIZE][GRID_SIZE];
+    calculateProbabilityGrid(&view, opponentFleet, density);
+
+    int bestCells[CELL_COUNT];
+    int bestCellsCount = 0;
+    int best = argmaxMatchingCells(density, view.trackingGrid, '~', bestCells, &bestCellsCount);
+    if (bestCellsCount == 0) {
+        printf("No untargeted cells left.\n");
+        return;
     }
-    if (strcmp(command, "artillery") == 0 && player->artilleryAvailable) {
-        return true;
+
+    // Heatmap: untargeted cells scaled to 0-9 (any chance at all shows as at least 1). Shot cells
+    // show as on the player's own grid, so misses hardMode hides stay hidden.
+    char heat[GRID_SIZE][GRID_SIZE];
+    for (int y = 0; y < GRID_SIZE; y++) {
+        for (int x = 0; x < GRID_SIZE; x++) {
+            if (view.trackingGrid[y][x] != '~') {
+                heat[y][x] = player->trackingGrid[y][x];
+            } else if (best <= 0 || density[y][x] == 0) {
+                heat[y][x] = '0';
+            } else {
+                heat[y][x] = (char)('0' + (density[y][x] * 9 + best - 1) / best);
+            }
+        }
     }
-    if (strcmp(command, "torpedo") == 0 && player->torpedoAvailable) {
-        return true;
+    printf("Hint heatmap (9 = most likely):\n");
+    displayGrid(heat, true);
+
+    int cell = bestCells[0];
+    printf("Suggested fire: %c%d\n", 'A' + cell % GRID_SIZE, cell / GRID_SIZE + 1);
+
+    Bitboard untargeted = cellMask(view.trackingGrid, '~', '~');
+    if (player->artilleryAvailable) {
+        int bestScore = -1;
+        Coordinate bestAnchor = { 0, 0 };
+        for (int y = 0; y < GRID_SIZE; y++) {
+            for (int x = 0; x < GRID_SIZE; x++) {
+                Bitboard footprint = bitboardAnd(windowFootprint((Coordinate){ x, y }), untargeted);
+                int score = 0;
+                for (int i = y; i < GRID_SIZE && i <= y + 1; i++) {
+                    for (int j = x; j < GRID_SIZE && j <= x + 1; j++) {
+                        if ((footprint.rows[i] >> j) & 1) score += density[i][j];
+                    }
+                }
+                if (score > bestScore) {
+                    bestScore = score;
+                    bestAnchor = (Coordinate){ x, y };
+                }
+            }
+        }
+        printf("Suggested artillery: %c%d\n", 'A' + bestAnchor.x, bestAnchor.y + 1);
+    }
+
+    if (player->torpedoAvailable) {
+        int bestScore = -1;
+        char bestType = 'r';
+        int bestLine = 0;
+        for (int line = 0; line < GRID_SIZE; line++) {
+            int rowScore = 0;
+            int columnScore = 0;
+            for (int k = 0; k < GRID_SIZE; k++) {
+                if ((untargeted.rows[line] >> k) & 1) rowScore += density[line][k];
+                if ((untargeted.rows[k] >> line) & 1) columnScore += density[k][line];
+            }
+            if (rowScore > bestScore) {
+                bestScore = rowScore;
+                bestType = 'r';
+                bestLine = line;
+            }
+            if (columnScore > bestScore) {
+                bestScore = columnScore;
+                bestType = 'c';
+                bestLine = line;
+            }
+        }
+        if (bestType == 'r') {
+            printf("Suggested torpedo: row %d\n", bestLine + 1);
+        } else {
+            printf("Suggested torpedo: column %c\n", 'A' + bestLine);
+        }
+    }
+}
+
+bool isValidCommand(const char* command, Player* player) {
+    static const char* commands[] = { "fire", "radar", "smoke", "artillery", "torpedo" }; // ActionType order
+    for (int type = ACTION_FIRE; type <= ACTION_TORPEDO; type++) {
+        if (strcmp(command, commands[type]) == 0) return isActionAvailable(player, (ActionType)type);
     }
     return false;
 }
 
+// The one place the rules say which kinds of move a player may make this turn
+bool isActionAvailable(Player* player, ActionType type) {
+    if (type == ACTION_FIRE) return true;
+    if (type == ACTION_RADAR) return player->radarSweepsUsed < MAX_RADAR_SWEEPS;
+    if (type == ACTION_SMOKE) return player->smokeScreensUsed < player->shipsSunk;
+    if (type == ACTION_ARTILLERY) return player->artilleryAvailable;
+    if (type == ACTION_TORPEDO) return player->torpedoAvailable;
+    return false;
+}
+
+// Every legal action of the player, as codes in ActionType order: fire at each cell not shot yet
+// (shotHistory, so misses hidden by hard tracking still count as shot), then radar, smoke and
+// artillery windows at every anchor, then torpedo rows and columns. No allocation; the caller's
+// array takes any state.
+int generateLegalActions(Player* player, ActionCode actions[MAX_LEGAL_ACTIONS]) {
+    int count = 0;
+    for (int y = 0; y < GRID_SIZE; y++) {
+        unsigned int shot = player->shotHistory.rows[y];
+        for (int x = 0; x < GRID_SIZE; x++) {
+            actions[count] = ACTION_CODE(ACTION_FIRE, y * GRID_SIZE + x);
+            count += !((shot >> x) & 1); // Branch-free: the slot is overwritten unless the cell is open
+        }
+    }
+    for (int type = ACTION_RADAR; type <= ACTION_ARTILLERY; type++) {
+        if (!isActionAvailable(player, (ActionType)type)) continue;
+        for (int cell = 0; cell < CELL_COUNT; cell++) {
+            actions[count++] = ACTION_CODE(type, cell);
+        }
+    }
+    if (isActionAvailable(player, ACTION_TORPEDO)) {
+        for (int line = 0; line < 2 * GRID_SIZE; line++) {
+            actions[count++] = ACTION_CODE(ACTION_TORPEDO, line);
+        }
+    }
+    return count;
+}
+
 void getInput(char* input, int size) {
     if (fgets(input, size, stdin) != NULL) {
         size_t len = strlen(input);
@@ -1052,51 +2118,57 @@ Coordinate getRandomCoordinate() {
 }
 
 Coordinate getNextTarget(Player* bot, Fleet* opponentFleet) {
+    // Early positions come straight from the opening book when it speaks for this bot
+    Coordinate bookMove;
+    if (openingBookApplies(bot, opponentFleet) && lookupOpeningMove(bot->trackingGrid, &bookMove)) {
+        return bookMove;
+    }
+
     int probabilityGrid[GRID_SIZE][GRID_SIZE];
     calculateProbabilityGrid(bot, opponentFleet, probabilityGrid);
 
-    int maxProbability = -1;
-    Coordinate bestCoords[GRID_SIZE * GRID_SIZE];
-    int bestCoordsCount = 0;
-
-    for (int y = 0; y < GRID_SIZE; y++) {
-        for (int x = 0; x < GRID_SIZE; x++) {
-            if (bot->trackingGrid[y][x] == '~') {
-                int prob = probabilityGrid[y][x];
-                if (prob > maxProbability) {
-                    maxProbability = prob;
-                    bestCoordsCount = 0;
-                    bestCoords[bestCoordsCount++] = (Coordinate){ x, y };
-                } else if (prob == maxProbability) {
-                    bestCoords[bestCoordsCount++] = (Coordinate){ x, y };
-                }
-            }
-        }
-    }
+    int bestCells[CELL_COUNT];
+    int bestCellsCount = 0;
+    argmaxMatchingCells(probabilityGrid, bot->trackingGrid, '~', bestCells, &bestCellsCount);
 
-    if (bestCoordsCount > 0) {
+    if (bestCellsCount > 0) {
         // Randomly select among the best coordinates
-        int idx = rand() % bestCoordsCount;
-        return bestCoords[idx];
+        int cell = bestCells[rand() % bestCellsCount];
+        return (Coordinate){ cell % GRID_SIZE, cell / GRID_SIZE };
     }
 
     // Fallback to random if no valid targets
     return getRandomCoordinate();
 }
 
+// Identical knowledge states recur across turns and games, so densities are served from the
+// transposition table whenever the state (or one of its mirror images) was seen before.
+// The table only ever holds the canonical orientation of a state.
 void calculateProbabilityGrid(Player* bot, Fleet* opponentFleet, int probabilityGrid[GRID_SIZE][GRID_SIZE]) {
+    int canonical[GRID_SIZE][GRID_SIZE];
+    unsigned long long key;
+    int symmetry = canonicalizeDensityState(bot, opponentFleet, &key);
+
+    if (probeTranspositionTable(key, canonical)) {
+        transformDensity(canonical, probabilityGrid, inverseSymmetry(symmetry));
+        return;
+    }
+    computeProbabilityGrid(bot, opponentFleet, probabilityGrid);
+    transformDensity(probabilityGrid, canonical, symmetry);
+    storeTranspositionTable(key, canonical);
+}
+
+void computeProbabilityGrid(Player* bot, Fleet* opponentFleet, int probabilityGrid[GRID_SIZE][GRID_SIZE]) {
     // Initialize probability grid to zero
     memset(probabilityGrid, 0, sizeof(int) * GRID_SIZE * GRID_SIZE);
 
-    bool hasHits = false;
+    char view[GRID_SIZE][GRID_SIZE];
+    densityView(bot, view);
+
     // First, check if there are any hits on the tracking grid
-    for (int y = 0; y < GRID_SIZE && !hasHits; y++) {
-        for (int x = 0; x < GRID_SIZE && !hasHits; x++) {
-            if (bot->trackingGrid[y][x] == '*') {
-                hasHits = true;
-            }
-        }
-    }
+    bool hasHits = anyCellMatches(view, '*');
+
+    bool parityHunt = !hasHits && bot->params->checkerboardHunt;
 
     // Iterate over each remaining ship
     for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) {
@@ -1110,81 +2182,45 @@ void calculateProbabilityGrid(Player* bot, Fleet* opponentFleet, int probability
         // Horizontal placements
         for (int y = 0; y < GRID_SIZE; y++) {
             for (int x = 0; x <= GRID_SIZE - shipSize; x++) {
-                bool valid = true;
-                bool overlapsHit = false;
-                for (int k = 0; k < shipSize; k++) {
-                    char cell = bot->trackingGrid[y][x + k];
-                    if (cell == 'o') { // Miss
-                        valid = false;
-                        break;
-                    } else if (cell == '*') {
-                        overlapsHit = true;
-                    }
-                }
-                if (valid) {
-                    // If not in targeting mode (no hits), only consider placements on checkerboard
-                    if (!hasHits) {
-                        bool onCheckerboard = true;
-                        for (int k = 0; k < shipSize; k++) {
-                            int tx = x + k;
-                            if ((tx + y) % 2 != 0) {
-                                onCheckerboard = false;
-                                break;
-                            }
-                        }
-                        if (!onCheckerboard) {
-                            continue; // Skip this placement
-                        }
-                    }
-                    // If overlaps with a hit, give higher probability
-                    int increment = overlapsHit ? 10 : 1;
-                    for (int k = 0; k < shipSize; k++) {
-                        probabilityGrid[y][x + k] += increment;
-                    }
-                }
+                accumulatePlacement(bot, view, parityHunt, shipIdx, shipSize, 0, x, y, 1, probabilityGrid);
             }
         }
 
         // Vertical placements
         for (int x = 0; x < GRID_SIZE; x++) {
             for (int y = 0; y <= GRID_SIZE - shipSize; y++) {
-                bool valid = true;
-                bool overlapsHit = false;
-                for (int k = 0; k < shipSize; k++) {
-                    char cell = bot->trackingGrid[y + k][x];
-                    if (cell == 'o') { // Miss
-                        valid = false;
-                        break;
-                    } else if (cell == '*') {
-                        overlapsHit = true;
-                    }
-                }
-                if (valid) {
-                    // If not in targeting mode (no hits), only consider placements on checkerboard
-                    if (!hasHits) {
-                        bool onCheckerboard = true;
-                        for (int k = 0; k < shipSize; k++) {
-                            int ty = y + k;
-                            if ((x + ty) % 2 != 0) {
-                                onCheckerboard = false;
-                                break;
-                            }
-                        }
-                        if (!onCheckerboard) {
-                            continue; // Skip this placement
-                        }
-                    }
-                    // If overlaps with a hit, give higher probability
-                    int increment = overlapsHit ? 10 : 1;
-                    for (int k = 0; k < shipSize; k++) {
-                        probabilityGrid[y + k][x] += increment;
-                    }
-                }
+                accumulatePlacement(bot, view, parityHunt, shipIdx, shipSize, 1, x, y, 1, probabilityGrid);
             }
         }
     }
 }
 
+// Adds (sign 1) or takes back (sign -1) one placement's share of the density over view
+void accumulatePlacement(Player* bot, char view[GRID_SIZE][GRID_SIZE], bool parityHunt, int shipIdx, int size,
+                         int vertical, int x, int y, int sign, int probabilityGrid[GRID_SIZE][GRID_SIZE]) {
+    bool overlapsHit = false;
+    for (int k = 0; k < size; k++) {
+        char cell = vertical ? view[y + k][x] : view[y][x + k];
+        if (cell == 'o') { // Miss
+            return;
+        } else if (cell == '*') {
+            overlapsHit = true;
+        }
+    }
+
+    // If overlaps with a hit, give higher probability
+    int increment = sign * (overlapsHit ? bot->params->hitWeight : bot->params->plainWeight) *
+                    placementWeight(shipIdx, vertical ? 'v' : 'h', x, y);
+    for (int k = 0; k < size; k++) {
+        int cx = vertical ? x : x + k;
+        int cy = vertical ? y + k : y;
+        // If not in targeting mode (no hits), only checkerboard cells are worth a shot;
+        // every ship covers at least one of them
+        if (parityHunt && (cx + cy) % 2 != 0) continue;
+        probabilityGrid[cy][cx] += increment;
+    }
+}
+
 void addAdjacentTargets(Player* bot, Coordinate coord) {
     int dx[] = { 0, 1, 0, -1 }; // N, E, S, W
     int dy[] = { -1, 0, 1, 0 };
@@ -1195,7 +2231,7 @@ void addAdjacentTargets(Player* bot, Coordinate coord) {
         int ny = coord.y + dy[dir];
 
         if (nx >= 0 && nx < GRID_SIZE && ny >= 0 && ny < GRID_SIZE) {
-            if (bot->trackingGrid[ny][nx] == '*') {
+            if (bot->trackingGrid[ny][nx] == '*' && !isResolvedHit(bot, nx, ny)) {
                 // Direction found; extend in this direction
                 int ex = coord.x;
                 int ey = coord.y;
@@ -1226,28 +2262,280 @@ void addAdjacentTargets(Player* bot, Coordinate coord) {
     }
 }
 
+// Queues a cell for targeting mode; the occupancy bitboard makes duplicates an O(1) no-op.
+// The priority is filled in from the probability grid when the bot next pops a target.
 void addPotentialTarget(Player* player, Coordinate coord) {
-    for (int i = 0; i < player->potentialTargetCount; i++) {
-        if (player->potentialTargets[i].x == coord.x && player->potentialTargets[i].y == coord.y) {
-            return;
+    TargetQueue* queue = &player->potentialTargets;
+    unsigned short bit = (unsigned short)(1 << coord.x);
+    if (queue->queued.rows[coord.y] & bit) {
+        return;
+    }
+    int cell = coord.y * GRID_SIZE + coord.x;
+    queue->queued.rows[coord.y] |= bit;
+    queue->cells[queue->count] = (unsigned char)cell;
+    queue->keys[queue->count] = -1;
+    queue->slots[cell] = (unsigned char)queue->count;
+    queue->count++;
+    siftTargetUp(queue, queue->count - 1);
+}
+
+void initializeTargetQueue(TargetQueue* queue) {
+    queue->count = 0;
+    memset(&queue->queued, 0, sizeof(queue->queued));
+    memset(queue->keyedView, '~', sizeof(queue->keyedView));
+    queue->keyedSunk = 0;
+}
+
+void swapTargets(TargetQueue* queue, int a, int b) {
+    unsigned char cell = queue->cells[a];
+    int key = queue->keys[a];
+    queue->cells[a] = queue->cells[b];
+    queue->keys[a] = queue->keys[b];
+    queue->cells[b] = cell;
+    queue->keys[b] = key;
+    queue->slots[queue->cells[a]] = (unsigned char)a;
+    queue->slots[queue->cells[b]] = (unsigned char)b;
+}
+
+void siftTargetUp(TargetQueue* queue, int index) {
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (queue->keys[parent] >= queue->keys[index]) break;
+        swapTargets(queue, parent, index);
+        index = parent;
+    }
+}
+
+void siftTargetDown(TargetQueue* queue, int index) {
+    while (true) {
+        int largest = index;
+        int left = 2 * index + 1;
+        int right = left + 1;
+        if (left < queue->count && queue->keys[left] > queue->keys[largest]) largest = left;
+        if (right < queue->count && queue->keys[right] > queue->keys[largest]) largest = right;
+        if (largest == index) break;
+        swapTargets(queue, index, largest);
+        index = largest;
+    }
+}
+
+void removeTopTarget(TargetQueue* queue) {
+    int cell = queue->cells[0];
+    queue->queued.rows[cell / GRID_SIZE] &= (unsigned short)~(1 << (cell % GRID_SIZE));
+    queue->count--;
+    if (queue->count > 0) {
+        queue->cells[0] = queue->cells[queue->count];
+        queue->keys[0] = queue->keys[queue->count];
+        queue->slots[queue->cells[0]] = 0;
+        siftTargetDown(queue, 0);
+    }
+}
+
+// Scores a queued cell by the placements of unsunk ships that can still cover it, each weighted by
+// how many hits it would explain, so cells that extend a line of hits outrank its flanks. Unlike the
+// hunt density there is no checkerboard filter: radar contacts are queued before any hit exists.
+// view is the bot's densityView.
+int targetPriority(Player* bot, Fleet* opponentFleet, char view[GRID_SIZE][GRID_SIZE], Coordinate coord) {
+    int priority = 0;
+
+    for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) {
+        Ship* ship = &opponentFleet->ships[shipIdx];
+        if (ship->sunk) continue;
+
+        for (int vertical = 0; vertical <= 1; vertical++) {
+            // Every placement whose k-th cell is the target
+            for (int k = 0; k < ship->size; k++) {
+                int x = vertical ? coord.x : coord.x - k;
+                int y = vertical ? coord.y - k : coord.y;
+                if (x < 0 || y < 0) continue;
+                if ((vertical ? y : x) + ship->size > GRID_SIZE) continue;
+
+                bool valid = true;
+                int hits = 0;
+                for (int j = 0; j < ship->size; j++) {
+                    char cell = vertical ? view[y + j][x] : view[y][x + j];
+                    if (cell == 'o') {
+                        valid = false;
+                        break;
+                    } else if (cell == '*') {
+                        hits++;
+                    }
+                }
+                if (valid) {
+                    priority += (bot->params->plainWeight + hits * bot->params->hitWeight) *
+                                placementWeight(shipIdx, vertical ? 'v' : 'h', x, y);
+                }
+            }
+        }
+    }
+    return priority;
+}
+
+// Pops the most likely queued cell. A key only depends on the cells a placement through it can
+// cover, so only entries in the row or column of a cell that changed in the bot's view since the last
+// pop (a shot, a sink's resolved hits), and within ship reach of it, are re-keyed and sifted back into
+// place; a sink re-keys everything, as it changes which ships count. Entries that were shot in the
+// meantime or can no longer hold a ship drop to zero and are pruned here, lazily, once they surface.
+bool popBestTarget(Player* bot, Fleet* opponentFleet, Coordinate* coord) {
+    TargetQueue* queue = &bot->potentialTargets;
+    if (queue->count == 0) return false;
+
+    char view[GRID_SIZE][GRID_SIZE];
+    densityView(bot, view);
+    unsigned char sunk = 0;
+    int reach = 0;
+    for (int i = 0; i < SHIP_TYPES; i++) {
+        if (opponentFleet->ships[i].sunk) {
+            sunk |= (unsigned char)(1 << i);
+        } else if (opponentFleet->ships[i].size > reach) {
+            reach = opponentFleet->ships[i].size;
+        }
+    }
+
+    Bitboard changed = { { 0 } };
+    for (int y = 0; y < GRID_SIZE; y++) {
+        for (int x = 0; x < GRID_SIZE; x++) {
+            if (view[y][x] != queue->keyedView[y][x]) changed.rows[y] |= (unsigned short)(1 << x);
+        }
+    }
+    Bitboard stale = changed;
+    for (int y = 0; y < GRID_SIZE; y++) {
+        for (int d = 1; d < reach; d++) {
+            stale.rows[y] |= (unsigned short)(((changed.rows[y] << d) | (changed.rows[y] >> d)) & FULL_ROW);
+            if (y - d >= 0) stale.rows[y] |= changed.rows[y - d];
+            if (y + d < GRID_SIZE) stale.rows[y] |= changed.rows[y + d];
+        }
+    }
+
+    // Collected first: sifting moves entries around the heap
+    unsigned char rekey[GRID_SIZE * GRID_SIZE];
+    int rekeyCount = 0;
+    for (int i = 0; i < queue->count; i++) {
+        int cell = queue->cells[i];
+        if (sunk != queue->keyedSunk || queue->keys[i] < 0 ||
+            ((stale.rows[cell / GRID_SIZE] >> (cell % GRID_SIZE)) & 1)) {
+            rekey[rekeyCount++] = (unsigned char)cell;
+        }
+    }
+    for (int r = 0; r < rekeyCount; r++) {
+        int cell = rekey[r];
+        Coordinate target = { cell % GRID_SIZE, cell / GRID_SIZE };
+        int index = queue->slots[cell];
+        int previous = queue->keys[index];
+        queue->keys[index] = view[target.y][target.x] == '~' ? targetPriority(bot, opponentFleet, view, target) : 0;
+        if (queue->keys[index] > previous) {
+            siftTargetUp(queue, index);
+        } else {
+            siftTargetDown(queue, index);
         }
     }
-    if (player->potentialTargetCount < GRID_SIZE * GRID_SIZE) {
-        player->potentialTargets[player->potentialTargetCount++] = coord;
+    memcpy(queue->keyedView, view, sizeof(view));
+    queue->keyedSunk = sunk;
+
+    while (queue->count > 0) {
+        int cell = queue->cells[0];
+        int key = queue->keys[0];
+        removeTopTarget(queue);
+        if (key > 0) {
+            coord->x = cell % GRID_SIZE;
+            coord->y = cell / GRID_SIZE;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool isResolvedHit(Player* player, int x, int y) {
+    return (player->resolvedHits.rows[y] >> x) & 1;
+}
+
+// The tracking grid as the density engine sees it: hits already attributed to a sunk ship are
+// blocked cells like misses, so only hits on floating ships count as hits
+void densityView(Player* bot, char view[GRID_SIZE][GRID_SIZE]) {
+    memcpy(view, bot->trackingGrid, sizeof(char) * GRID_SIZE * GRID_SIZE);
+    for (int y = 0; y < GRID_SIZE; y++) {
+        if (!bot->resolvedHits.rows[y]) continue;
+        for (int x = 0; x < GRID_SIZE; x++) {
+            if (isResolvedHit(bot, x, y)) view[y][x] = 'o';
+        }
+    }
+}
+
+// Counts the lines of unresolved hits of the sunk ship's length through the sinking shot; the last
+// one found is left in line
+int findSunkShipLines(Player* player, SunkShipReport report, Bitboard* line) {
+    int lines = 0;
+    for (int vertical = 0; vertical <= 1; vertical++) {
+        for (int k = 0; k < report.size; k++) {
+            int x = vertical ? report.coord.x : report.coord.x - k;
+            int y = vertical ? report.coord.y - k : report.coord.y;
+            if (x < 0 || y < 0) continue;
+            if ((vertical ? y : x) + report.size > GRID_SIZE) continue;
+
+            bool valid = true;
+            for (int j = 0; j < report.size && valid; j++) {
+                int cx = vertical ? x : x + j;
+                int cy = vertical ? y + j : y;
+                valid = player->trackingGrid[cy][cx] == '*' && !isResolvedHit(player, cx, cy);
+            }
+            if (!valid) continue;
+
+            lines++;
+            memset(line, 0, sizeof(*line));
+            for (int j = 0; j < report.size; j++) {
+                if (vertical) {
+                    line->rows[y + j] |= (unsigned short)(1 << x);
+                } else {
+                    line->rows[y] |= (unsigned short)(1 << (x + j));
+                }
+            }
+        }
+    }
+    return lines;
+}
+
+// Attributes pending sinks to hit clusters. A sink is resolved once exactly one line of unresolved
+// hits fits it; resolving one can disambiguate another, so this repeats until nothing changes.
+// Ambiguous sinks stay pending and their hits keep driving the search until later shots settle them.
+// A sink no line fits (only possible if an earlier attribution was wrong) stays pending as well, so
+// its hits are never dropped from the density on a guess.
+void resolveHitClusters(Player* player) {
+    bool progress = true;
+    while (progress) {
+        progress = false;
+        for (int i = 0; i < player->pendingSinkCount; i++) {
+            Bitboard line;
+            int lines = findSunkShipLines(player, player->pendingSinks[i], &line);
+            if (lines != 1) continue;
+
+            for (int y = 0; y < GRID_SIZE; y++) {
+                player->resolvedHits.rows[y] |= line.rows[y];
+            }
+            player->pendingSinks[i--] = player->pendingSinks[--player->pendingSinkCount];
+            progress = true;
+        }
     }
 }
 
+void recordSunkShip(Player* player, Coordinate coord, int size) {
+    if (player->pendingSinkCount < SHIP_TYPES) {
+        SunkShipReport report = { coord, size };
+        player->pendingSinks[player->pendingSinkCount++] = report;
+    }
+    resolveHitClusters(player);
+}
+
 Coordinate getBestArtilleryTarget(Player* bot) {
     Coordinate bestCoord = { -1, -1 };
     int maxUntargeted = 0;
+    WindowCounts untargeted = windowCount(cellMask(bot->trackingGrid, '~', '~'));
 
     for (int y = 0; y < GRID_SIZE; y++) {
         for (int x = 0; x < GRID_SIZE; x++) {
-            Coordinate coord = { x, y };
-            int untargetedCount = countUntargetedTilesInArtilleryArea(bot, coord);
+            int untargetedCount = windowCountAt(&untargeted, x, y);
             if (untargetedCount > maxUntargeted) {
                 maxUntargeted = untargetedCount;
-                bestCoord = coord;
+                bestCoord = (Coordinate){ x, y };
                 if (maxUntargeted == 4) {
                     return bestCoord;
                 }
@@ -1263,37 +2551,19 @@ Coordinate getBestArtilleryTarget(Player* bot) {
 }
 
 int countUntargetedTilesInArtilleryArea(Player* bot, Coordinate coord) {
-    int count = 0;
-    int xStart = coord.x;
-    int yStart = coord.y;
-    int xEnd = coord.x + 1;
-    int yEnd = coord.y + 1;
-
-    handleEdgeCoordinates(&xStart, &xEnd);
-    handleEdgeCoordinates(&yStart, &yEnd);
-
-    for (int i = yStart; i <= yEnd; i++) {
-        for (int j = xStart; j <= xEnd; j++) {
-            if (bot->trackingGrid[i][j] == '~') {
-                count++;
-            }
-        }
-    }
-    return count;
+    return bitboardCount(bitboardAnd(windowFootprint(coord), cellMask(bot->trackingGrid, '~', '~')));
 }
 
 bool chooseTorpedoTarget(Player* bot, Player* opponent, Fleet* opponentFleet, bool hardMode) {
     int maxUntargeted = 0;
     char targetType = 'r';
     int targetIndex = -1;
+    int rowCounts[GRID_SIZE];
+    int columnCounts[GRID_SIZE];
+    countCellsPerLine(bot->trackingGrid, '~', rowCounts, columnCounts);
 
     for (int row = 0; row < GRID_SIZE; row++) {
-        int untargetedFound = 0;
-        for (int col = 0; col < GRID_SIZE; col++) {
-            if (bot->trackingGrid[row][col] == '~') {
-                untargetedFound++;
-            }
-        }
+        int untargetedFound = rowCounts[row];
         if (untargetedFound > maxUntargeted) {
             maxUntargeted = untargetedFound;
             targetType = 'r';
@@ -1302,12 +2572,7 @@ bool chooseTorpedoTarget(Player* bot, Player* opponent, Fleet* opponentFleet, bo
     }
 
     for (int col = 0; col < GRID_SIZE; col++) {
-        int untargetedFound = 0;
-        for (int row = 0; row < GRID_SIZE; row++) {
-            if (bot->trackingGrid[row][col] == '~') {
-                untargetedFound++;
-            }
-        }
+        int untargetedFound = columnCounts[col];
         if (untargetedFound > maxUntargeted) {
             maxUntargeted = untargetedFound;
             targetType = 'c';
@@ -1319,57 +2584,3874 @@ bool chooseTorpedoTarget(Player* bot, Player* opponent, Fleet* opponentFleet, bo
         return false;
     }
 
+    launchTorpedo(bot, opponent, opponentFleet, targetType, targetIndex, hardMode);
+    return true;
+}
+
+// targetType is 'r' for a row or 'c' for a column
+void launchTorpedo(Player* bot, Player* opponent, Fleet* opponentFleet, char targetType, int targetIndex, bool hardMode) {
     if (targetType == 'r') {
-        printf("%s uses Torpedo at row %d\n", bot->name, targetIndex + 1);
+        gamePrintf("%s uses Torpedo at row %d\n", bot->name, targetIndex + 1);
         char rowStr[3];
         sprintf(rowStr, "%d", targetIndex + 1);
         torpedo(bot, opponent, opponentFleet, rowStr, hardMode);
     } else if (targetType == 'c') {
-        printf("%s uses Torpedo at column %c\n", bot->name, 'A' + targetIndex);
+        gamePrintf("%s uses Torpedo at column %c\n", bot->name, 'A' + targetIndex);
         char colStr[2];
         colStr[0] = 'a' + targetIndex;
         colStr[1] = '\0';
         torpedo(bot, opponent, opponentFleet, colStr, hardMode);
     }
+}
 
-    return true;
+// Placements that avoid every known-empty cell. A placement lying entirely on hits is left out too:
+// that ship would already have been announced as sunk.
+void collectPlacements(Fleet* opponentFleet, Bitboard blocked, Bitboard hits, PlacementSet* set) {
+    for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) {
+        set->count[shipIdx] = 0;
+        if (opponentFleet->ships[shipIdx].sunk) continue;
+
+        int size = opponentFleet->ships[shipIdx].size;
+        for (int cell = 0; cell < CELL_COUNT; cell++) {
+            for (int vertical = 0; vertical <= 1; vertical++) {
+                int x = cell % GRID_SIZE;
+                int y = cell / GRID_SIZE;
+                if ((vertical ? y : x) + size > GRID_SIZE) continue;
+
+                Bitboard mask = shipPlacementMask((unsigned char)(cell | (vertical ? 0x80 : 0)), size);
+                if (!bitboardEmpty(bitboardAnd(mask, blocked))) continue;
+                if (bitboardCount(bitboardAnd(mask, hits)) == size) continue;
+                set->masks[shipIdx][set->count[shipIdx]++] = mask;
+            }
+        }
+    }
 }
 
-Coordinate getSmokeScreenCoordinateForBot(Player* bot) {
+// xorshift32: the sampler keeps its own stream so it can run off the main thread, where rand() is
+// not safe to share
+unsigned int nextRandom(unsigned int* state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return *state = x;
+}
+
+// Uniform in [0, bound) with no modulo bias: multiply-and-reject (Lemire), which almost never
+// needs the division
+unsigned int randomBelow(unsigned int* state, unsigned int bound) {
+    unsigned long long product = (unsigned long long)nextRandom(state) * bound;
+    unsigned int low = (unsigned int)product;
+    if (low < bound) {
+        unsigned int threshold = (0u - bound) % bound;
+        while (low < threshold) {
+            product = (unsigned long long)nextRandom(state) * bound;
+            low = (unsigned int)product;
+        }
+    }
+    return (unsigned int)(product >> 32);
+}
+
+void bitboardToCellMask(Bitboard board, unsigned long long mask[CELL_MASK_WORDS]) {
+    memset(mask, 0, sizeof(unsigned long long) * CELL_MASK_WORDS);
     for (int y = 0; y < GRID_SIZE; y++) {
         for (int x = 0; x < GRID_SIZE; x++) {
-            bool hasShip = false;
-            int xStart = x;
-            int yStart = y;
-            int xEnd = x + 1;
-            int yEnd = y + 1;
-
-            handleEdgeCoordinates(&xStart, &xEnd);
-            handleEdgeCoordinates(&yStart, &yEnd);
-
-            for (int i = yStart; i <= yEnd; i++) {
-                for (int j = xStart; j <= xEnd; j++) {
-                    char cell = bot->grid[i][j];
-                    if (cell >= 'A' && cell <= 'Z') {
-                        hasShip = true;
-                        break;
-                    }
+            int cell = y * GRID_SIZE + x;
+            if ((board.rows[y] >> x) & 1) mask[cell / 64] |= 1ULL << (cell % 64);
+        }
+    }
+}
+
+// Tables of every placement of each unsunk ship that avoids mustNot and does not lie entirely on
+// hits; sunk ships are left out. constraints may be NULL. Returns false if some ship has nowhere to go.
+bool initializeFleetSampler(FleetSampler* sampler, const Fleet* fleet, const FleetConstraints* constraints) {
+    FleetConstraints none;
+    memset(&none, 0, sizeof(none));
+    if (!constraints) constraints = &none;
+    bitboardToCellMask(constraints->must, sampler->must);
+
+    sampler->shipCount = 0;
+    for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) {
+        sampler->count[shipIdx] = 0;
+        if (fleet->ships[shipIdx].sunk) continue;
+
+        int size = fleet->ships[shipIdx].size;
+        for (int cell = 0; cell < CELL_COUNT; cell++) {
+            for (int vertical = 0; vertical <= 1; vertical++) {
+                if ((vertical ? cell / GRID_SIZE : cell % GRID_SIZE) + size > GRID_SIZE) continue;
+
+                unsigned char placement = (unsigned char)(cell | (vertical ? 0x80 : 0));
+                Bitboard mask = shipPlacementMask(placement, size);
+                if (!bitboardEmpty(bitboardAnd(mask, constraints->mustNot))) continue;
+                if (bitboardCount(bitboardAnd(mask, constraints->hits)) == size) continue;
+
+                int index = sampler->count[shipIdx]++;
+                bitboardToCellMask(mask, sampler->masks[shipIdx][index]);
+                sampler->placements[shipIdx][index] = placement;
+            }
+        }
+        if (sampler->count[shipIdx] == 0) return false;
+
+        int position = sampler->shipCount++;
+        while (position > 0 && fleet->ships[sampler->ships[position - 1]].size < size) {
+            sampler->ships[position] = sampler->ships[position - 1];
+            position--;
+        }
+        sampler->ships[position] = shipIdx;
+    }
+    return true;
+}
+
+// One fleet drawn exactly uniformly among those meeting the constraints: each ship takes a uniform
+// placement from its table and the whole fleet is redrawn on any overlap or uncovered must cell.
+// Plain rejection is what keeps it exact; the largest ship goes first only so clashes show early.
+// picks[ship] is an index into the ship's table, -1 for ships left out. Returns false if maxAttempts
+// fleets in a row were rejected.
+bool sampleFleet(const FleetSampler* sampler, unsigned int* rng, int picks[SHIP_TYPES], int maxAttempts) {
+    for (int i = 0; i < SHIP_TYPES; i++) picks[i] = -1;
+
+    for (int attempt = 0; attempt < maxAttempts; attempt++) {
+        unsigned long long occupied[CELL_MASK_WORDS] = { 0 };
+        unsigned long long clash = 0;
+        for (int k = 0; k < sampler->shipCount && !clash; k++) {
+            int ship = sampler->ships[k];
+            int pick = (int)randomBelow(rng, (unsigned int)sampler->count[ship]);
+            const unsigned long long* mask = sampler->masks[ship][pick];
+            for (int w = 0; w < CELL_MASK_WORDS; w++) {
+                clash |= occupied[w] & mask[w];
+                occupied[w] |= mask[w];
+            }
+            picks[ship] = pick;
+        }
+        if (clash) continue;
+
+        unsigned long long uncovered = 0;
+        for (int w = 0; w < CELL_MASK_WORDS; w++) uncovered |= sampler->must[w] & ~occupied[w];
+        if (!uncovered) return true;
+    }
+    return false;
+}
+
+// Narrows tables built earlier to tighter constraints (mustNot and hits only ever grow within a game)
+// without rebuilding them: placements now ruled out and ships sunk since are dropped in place. Returns
+// false if some ship has nowhere left to go.
+bool pruneFleetSampler(FleetSampler* sampler, const Fleet* fleet, const FleetConstraints* constraints) {
+    unsigned long long mustNot[CELL_MASK_WORDS];
+    unsigned long long hits[CELL_MASK_WORDS];
+    bitboardToCellMask(constraints->mustNot, mustNot);
+    bitboardToCellMask(constraints->hits, hits);
+    bitboardToCellMask(constraints->must, sampler->must);
+
+    int kept = 0;
+    for (int k = 0; k < sampler->shipCount; k++) {
+        int ship = sampler->ships[k];
+        if (fleet->ships[ship].sunk) {
+            sampler->count[ship] = 0;
+            continue;
+        }
+
+        int count = 0;
+        for (int i = 0; i < sampler->count[ship]; i++) {
+            const unsigned long long* mask = sampler->masks[ship][i];
+            unsigned long long blocked = 0;
+            unsigned long long unhit = 0;
+            for (int w = 0; w < CELL_MASK_WORDS; w++) {
+                blocked |= mask[w] & mustNot[w];
+                unhit |= mask[w] & ~hits[w];
+            }
+            if (blocked || !unhit) continue;
+            if (count != i) {
+                memcpy(sampler->masks[ship][count], mask, sizeof(sampler->masks[ship][count]));
+                sampler->placements[ship][count] = sampler->placements[ship][i];
+            }
+            count++;
+        }
+        sampler->count[ship] = count;
+        if (count == 0) return false;
+        sampler->ships[kept++] = ship;
+    }
+    sampler->shipCount = kept;
+    return true;
+}
+
+// One layout of the unsunk ships, built hit-first: the lowest uncovered required cell (a live hit or
+// radar contact) gets a random placement through it from a random unplaced ship, until every
+// required cell is covered; the rest of the fleet is then dropped uniformly wherever it fits.
+// Returns false when the construction runs into a dead end.
+bool drawBeliefSample(const PlacementSet* set, Bitboard mustCover, Bitboard layout[SHIP_TYPES], unsigned int* rng) {
+    Bitboard occupied = { { 0 } };
+    bool placed[SHIP_TYPES] = { false };
+    for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) {
+        memset(&layout[shipIdx], 0, sizeof(Bitboard));
+        if (set->count[shipIdx] == 0) placed[shipIdx] = true; // Sunk
+    }
+
+    for (int y = 0; y < GRID_SIZE; y++) {
+        while (mustCover.rows[y]) {
+            int x = 0;
+            while (!((mustCover.rows[y] >> x) & 1)) x++;
+            unsigned short bit = (unsigned short)(1 << x);
+
+            int candidates[SHIP_TYPES * 2 * GRID_SIZE];
+            int candidateCount = 0;
+            for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) {
+                if (placed[shipIdx]) continue;
+                for (int p = 0; p < set->count[shipIdx]; p++) {
+                    const Bitboard* mask = &set->masks[shipIdx][p];
+                    if (!(mask->rows[y] & bit)) continue;
+                    if (!bitboardEmpty(bitboardAnd(*mask, occupied))) continue;
+                    candidates[candidateCount++] = shipIdx * 2 * CELL_COUNT + p;
                 }
-                if (hasShip) break;
             }
-            if (hasShip) {
-                Coordinate coord = { xStart, yStart };
-                return coord;
+            if (candidateCount == 0) return false;
+
+            int pick = candidates[nextRandom(rng) % candidateCount];
+            int shipIdx = pick / (2 * CELL_COUNT);
+            layout[shipIdx] = set->masks[shipIdx][pick % (2 * CELL_COUNT)];
+            placed[shipIdx] = true;
+            for (int row = 0; row < GRID_SIZE; row++) {
+                occupied.rows[row] |= layout[shipIdx].rows[row];
+                mustCover.rows[row] &= (unsigned short)~layout[shipIdx].rows[row];
+            }
+        }
+    }
+
+    for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) {
+        if (placed[shipIdx]) continue;
+        bool fitted = false;
+        for (int attempt = 0; attempt < 32 && !fitted; attempt++) {
+            const Bitboard* mask = &set->masks[shipIdx][nextRandom(rng) % set->count[shipIdx]];
+            if (bitboardEmpty(bitboardAnd(*mask, occupied))) {
+                layout[shipIdx] = *mask;
+                fitted = true;
+            }
+        }
+        if (!fitted) return false;
+        for (int row = 0; row < GRID_SIZE; row++) occupied.rows[row] |= layout[shipIdx].rows[row];
+    }
+    return true;
+}
+
+// Tallies one sampled layout: which cells hold a ship, and which artillery windows and torpedo lines
+// would cover every still-unhit cell of some ship (and so sink it). Sunk ships have empty layouts.
+// Only set bits are visited, since the tally runs once per sample or particle every turn.
+void accumulateBelief(BeliefSamples* belief, Bitboard layout[SHIP_TYPES], Bitboard hits) {
+    belief->samples++;
+    for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) {
+        if (bitboardEmpty(layout[shipIdx])) continue;
+
+        int rowsUsed = 0;
+        int firstRow = 0;
+        int lastRow = 0;
+        unsigned short columnsUsed = 0;
+        for (int y = 0; y < GRID_SIZE; y++) {
+            for (unsigned short bits = layout[shipIdx].rows[y], x = 0; bits; bits >>= 1, x++) {
+                if (bits & 1) belief->cellHits[y][x]++;
+            }
+            unsigned short remaining = layout[shipIdx].rows[y] & (unsigned short)~hits.rows[y];
+            if (remaining) {
+                if (rowsUsed++ == 0) firstRow = y;
+                lastRow = y;
+                columnsUsed |= remaining;
+            }
+        }
+        if (!columnsUsed) continue;
+
+        if (rowsUsed == 1) belief->rowSinks[lastRow]++;
+        int firstColumn = 0;
+        while (!((columnsUsed >> firstColumn) & 1)) firstColumn++;
+        int lastColumn = firstColumn;
+        while (columnsUsed >> (lastColumn + 1)) lastColumn++;
+        if (firstColumn == lastColumn) belief->columnSinks[firstColumn]++;
+
+        // A window holds all remaining cells iff it holds their bounding box, so the anchors form a
+        // rectangle: up to one row and column back from the box's far corner to its near one
+        if (lastRow - firstRow <= 1 && lastColumn - firstColumn <= 1) {
+            for (int y = lastRow > 0 ? lastRow - 1 : 0; y <= firstRow; y++) {
+                for (int x = lastColumn > 0 ? lastColumn - 1 : 0; x <= firstColumn; x++) belief->windowSinks[y][x]++;
             }
         }
     }
-    Coordinate invalidCoord = { -1, -1 };
-    return invalidCoord;
 }
 
-void handleEdgeCoordinates(int* start, int* end) {
-    if (*start < 0) *start = 0;
-    if (*end >= GRID_SIZE) *end = GRID_SIZE - 1;
+void prepareBeliefInputs(Player* bot, Fleet* opponentFleet, BeliefInputs* inputs) {
+    char view[GRID_SIZE][GRID_SIZE];
+    densityView(bot, view);
+    Bitboard untargeted = cellMask(view, '~', '~');
+    inputs->blocked = cellMask(view, 'o', 'o');
+    inputs->hits = cellMask(view, '*', '*');
+    inputs->mustCover = inputs->hits;
+    for (int y = 0; y < GRID_SIZE; y++) {
+        inputs->blocked.rows[y] |= bot->radarClear.rows[y];
+        // Contacts already fired at are hits or resolved, so only untargeted ones add a constraint
+        inputs->mustCover.rows[y] |= bot->radarContacts.rows[y] & untargeted.rows[y];
+    }
+    // Zeroed first so two snapshots of the same knowledge compare equal byte for byte
+    memset(&inputs->set, 0, sizeof(inputs->set));
+    collectPlacements(opponentFleet, inputs->blocked, inputs->hits, &inputs->set);
+}
+
+// One batch of draws. Returns false once draws have kept failing, which happens when the knowledge
+// is inconsistent with the sampler's assumptions (e.g. hits of a sunk ship not yet attributed).
+bool sampleBeliefBatch(const BeliefInputs* inputs, BeliefSamples* belief, unsigned int* rng, int* failures) {
+    for (int i = 0; i < BELIEF_BATCH; i++) {
+        Bitboard layout[SHIP_TYPES];
+        if (drawBeliefSample(&inputs->set, inputs->mustCover, layout, rng)) {
+            accumulateBelief(belief, layout, inputs->hits);
+            *failures = 0;
+        } else if (++*failures >= BELIEF_GIVE_UP) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Draws layouts in batches until the deadline, or up to a fixed count in headless runs. A belief
+// pondered for the same knowledge during the opponent's turn is the starting point and the turn's
+// own batches are added to it, so a ponder cut short still leaves the move its full budget. With
+// particles, the population carried over from earlier turns only has to absorb the new evidence;
+// pondered layouts are then tallied alongside it.
+bool sampleBelief(Player* bot, Fleet* opponentFleet, double deadline, BeliefSamples* belief) {
+    static BeliefInputs inputs;
+    prepareBeliefInputs(bot, opponentFleet, &inputs);
+    bool pondered = takePonderedBelief(bot, &inputs, belief);
+    if (!pondered) memset(belief, 0, sizeof(*belief));
+
+    if (particleCapacity > 0) {
+        ParticleFilter* filter = particleFilterFor(bot);
+        if (updateParticleFilter(filter, bot, opponentFleet, &inputs, deadline)) {
+            tallyParticles(filter, opponentFleet, inputs.hits, belief);
+            return true;
+        }
+    }
+
+    unsigned int rng = (unsigned int)rand() * 2654435761u | 1;
+    int failures = 0;
+    do {
+        if (!sampleBeliefBatch(&inputs, belief, &rng, &failures)) break;
+    } while (searchBudgetLeft(deadline, belief->samples, HEADLESS_BELIEF_SAMPLES));
+    return belief->samples > 0;
+}
+
+#ifndef _WIN32
+void* ponderThread(void* arg) {
+    (void)arg;
+    int failures = 0;
+    while (ponder.belief.samples < PONDER_MAX_SAMPLES) {
+        pthread_mutex_lock(&ponder.lock);
+        bool cancel = ponder.cancel;
+        pthread_mutex_unlock(&ponder.lock);
+        if (cancel || !sampleBeliefBatch(&ponder.inputs, &ponder.belief, &ponder.rng, &failures)) break;
+    }
+    return NULL;
+}
+#endif
+
+// Starts sampling for the bot's next move in the background; the thread touches nothing but the
+// snapshot in the ponder state. Without POSIX threads (Windows builds) this does nothing and the
+// bot samples on its own turn as usual. Salvo turns need whole layouts rather than tallies, so
+// nothing is pondered for them.
+void startPondering(Player* bot, Fleet* opponentFleet) {
+    stopPondering();
+    if (bot->difficulty != HARD || hardMoveBudgetMs <= 0 || salvoShots != 0) return;
+#ifndef _WIN32
+    prepareBeliefInputs(bot, opponentFleet, &ponder.inputs);
+    memset(&ponder.belief, 0, sizeof(ponder.belief));
+    ponder.rng = (unsigned int)rand() * 2654435761u | 1;
+    ponder.cancel = false;
+    ponder.owner = bot;
+    pthread_mutex_init(&ponder.lock, NULL);
+    ponder.running = pthread_create(&ponder.thread, NULL, ponderThread, NULL) == 0;
+    if (!ponder.running) {
+        pthread_mutex_destroy(&ponder.lock);
+        ponder.owner = NULL;
+    }
+#else
+    (void)opponentFleet;
+#endif
+}
+
+// Cancels pondering and waits for the thread; the samples drawn so far stay available to the owner
+void stopPondering() {
+#ifndef _WIN32
+    if (!ponder.running) return;
+    pthread_mutex_lock(&ponder.lock);
+    ponder.cancel = true;
+    pthread_mutex_unlock(&ponder.lock);
+    pthread_join(ponder.thread, NULL);
+    pthread_mutex_destroy(&ponder.lock);
+    ponder.running = false;
+#endif
+}
+
+// Hands over the pondered belief if it was drawn for exactly this knowledge. It is consumed either
+// way, since the bot's knowledge changes with its own move.
+bool takePonderedBelief(Player* bot, const BeliefInputs* inputs, BeliefSamples* belief) {
+    stopPondering();
+    if (ponder.owner != bot) return false;
+    ponder.owner = NULL;
+    if (ponder.belief.samples == 0 || memcmp(&ponder.inputs, inputs, sizeof(*inputs)) != 0) return false;
+    *belief = ponder.belief;
+    return true;
+}
+
+// The bot's filter slot; a bot without one takes over the least recently used
+ParticleFilter* particleFilterFor(Player* bot) {
+    ParticleFilter* oldest = &particleFilters[0];
+    for (int i = 0; i < MAX_PARTICLE_FILTERS; i++) {
+        if (particleFilters[i].owner == bot) return &particleFilters[i];
+        if (particleFilters[i].lastUsed < oldest->lastUsed) oldest = &particleFilters[i];
+    }
+    return oldest;
+}
+
+// True if evidence only adds to what the filter absorbed, as it does from one turn of a game to the
+// next. Live hits may turn into blocked cells once their ship sinks, but nothing is ever taken back.
+bool extendsEvidence(const ParticleFilter* filter, const Fleet* fleet, const FleetConstraints* evidence) {
+    for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) {
+        if (filter->sunk[shipIdx] && !fleet->ships[shipIdx].sunk) return false;
+    }
+    for (int y = 0; y < GRID_SIZE; y++) {
+        if (filter->absorbed.mustNot.rows[y] & ~evidence->mustNot.rows[y]) return false;
+        unsigned short known = filter->absorbed.must.rows[y] | filter->absorbed.hits.rows[y];
+        if (known & ~(evidence->must.rows[y] | evidence->mustNot.rows[y])) return false;
+    }
+    return true;
+}
+
+// Placement byte of a single ship's cell mask: its top-left cell, vertical when that row holds one cell
+unsigned char placementOfMask(Bitboard mask) {
+    int y = 0;
+    while (!mask.rows[y]) y++;
+    int x = 0;
+    while (!((mask.rows[y] >> x) & 1)) x++;
+    bool vertical = (mask.rows[y] & (mask.rows[y] - 1)) == 0;
+    return (unsigned char)((y * GRID_SIZE + x) | (vertical ? 0x80 : 0));
+}
+
+// A particle explains the evidence if it covers every must cell, avoids every blocked cell and has
+// no unsunk ship lying entirely on hits
+bool particleExplains(const ParticleFilter* filter, const Particle* particle,
+                      const unsigned long long mustNot[CELL_MASK_WORDS], const unsigned long long hits[CELL_MASK_WORDS]) {
+    unsigned long long conflict = 0;
+    for (int w = 0; w < CELL_MASK_WORDS; w++) {
+        conflict |= particle->occupied[w] & mustNot[w];
+        conflict |= filter->sampler.must[w] & ~particle->occupied[w];
+    }
+    if (conflict) return false;
+
+    for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) {
+        if (particle->placements[shipIdx] == PLACEMENT_NONE) continue;
+        const unsigned long long* cells = filter->shipCells[shipIdx][particle->placements[shipIdx]];
+        unsigned long long unhit = 0;
+        for (int w = 0; w < CELL_MASK_WORDS; w++) unhit |= cells[w] & ~hits[w];
+        if (!unhit) return false;
+    }
+    return true;
+}
+
+// Fresh particles from index count up to target, for a new population (first move, or evidence no
+// particle foresaw) or to top up a thinned one: exact draws while they keep succeeding, hit-first
+// draws once the evidence makes them rare. Stops early at the deadline; resampling and rejuvenation
+// make up the rest. Returns the particles now held.
+int seedParticles(ParticleFilter* filter, const BeliefInputs* inputs, int count, int target, double deadline) {
+    int failures = 0;
+    bool exact = true;
+    while (count < target && failures < BELIEF_GIVE_UP) {
+        Particle* particle = &filter->particles[count];
+        int picks[SHIP_TYPES];
+        Bitboard layout[SHIP_TYPES];
+        if (exact && sampleFleet(&filter->sampler, &filter->rng, picks, PARTICLE_SEED_ATTEMPTS)) {
+            for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) {
+                particle->placements[shipIdx] = picks[shipIdx] < 0 ? PLACEMENT_NONE
+                                                                   : filter->sampler.placements[shipIdx][picks[shipIdx]];
+            }
+        } else {
+            exact = false;
+            if (!drawBeliefSample(&inputs->set, inputs->mustCover, layout, &filter->rng)) {
+                failures++;
+                continue;
+            }
+            for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) {
+                particle->placements[shipIdx] = bitboardEmpty(layout[shipIdx]) ? PLACEMENT_NONE : placementOfMask(layout[shipIdx]);
+            }
+        }
+        failures = 0;
+
+        memset(particle->occupied, 0, sizeof(particle->occupied));
+        for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) {
+            if (particle->placements[shipIdx] == PLACEMENT_NONE) continue;
+            const unsigned long long* cells = filter->shipCells[shipIdx][particle->placements[shipIdx]];
+            for (int w = 0; w < CELL_MASK_WORDS; w++) particle->occupied[w] |= cells[w];
+        }
+        count++;
+        if (count % BELIEF_BATCH == 0 && !searchBudgetLeft(deadline, count, target)) break;
+    }
+    return count;
+}
+
+// One Metropolis move: a random ship is offered a uniform placement from its table and takes it if
+// the fleet still explains the evidence. The proposal is symmetric and every consistent fleet is
+// equally likely, so accepting exactly the consistent proposals keeps the population uniform while
+// spreading the copies resampling made.
+void rejuvenateParticle(ParticleFilter* filter, Particle* particle) {
+    const FleetSampler* sampler = &filter->sampler;
+    int ship = sampler->ships[randomBelow(&filter->rng, (unsigned int)sampler->shipCount)];
+    int pick = (int)randomBelow(&filter->rng, (unsigned int)sampler->count[ship]);
+    const unsigned long long* current = filter->shipCells[ship][particle->placements[ship]];
+    const unsigned long long* proposal = sampler->masks[ship][pick];
+
+    unsigned long long occupied[CELL_MASK_WORDS];
+    unsigned long long rejected = 0;
+    for (int w = 0; w < CELL_MASK_WORDS; w++) {
+        unsigned long long others = particle->occupied[w] & ~current[w];
+        rejected |= others & proposal[w];
+        occupied[w] = others | proposal[w];
+        rejected |= sampler->must[w] & ~occupied[w];
+    }
+    if (rejected) return;
+    particle->placements[ship] = sampler->placements[ship][pick];
+    memcpy(particle->occupied, occupied, sizeof(occupied));
 }
 
+// Brings the bot's particles up to date with its knowledge. Evidence that extends what was absorbed
+// costs one pass over the population plus the rejuvenation sweeps; anything else (a new game, a
+// changed --particles) starts over from fresh draws. Returns false if no particle could be found.
+bool updateParticleFilter(ParticleFilter* filter, Player* bot, const Fleet* fleet, const BeliefInputs* inputs, double deadline) {
+    FleetConstraints evidence = { inputs->mustCover, inputs->blocked, inputs->hits };
+    filter->lastUsed = ++particleClock;
+
+    if (filter->capacity != particleCapacity) {
+        free(filter->particles);
+        free(filter->spare);
+        filter->particles = malloc(sizeof(Particle) * (size_t)particleCapacity);
+        filter->spare = malloc(sizeof(Particle) * (size_t)particleCapacity);
+        filter->owner = NULL;
+        filter->capacity = particleCapacity;
+        if (!filter->particles || !filter->spare) {
+            free(filter->particles);
+            free(filter->spare);
+            filter->particles = filter->spare = NULL;
+            filter->capacity = 0;
+            return false;
+        }
+    }
+
+    bool carried = filter->owner == bot && filter->fleet == fleet && bot->turnNumber >= filter->turn &&
+                   extendsEvidence(filter, fleet, &evidence) && pruneFleetSampler(&filter->sampler, fleet, &evidence);
+    if (!carried) {
+        filter->owner = NULL;
+        filter->count = 0;
+        if (!initializeFleetSampler(&filter->sampler, fleet, &evidence)) return false;
+        for (int k = 0; k < filter->sampler.shipCount; k++) {
+            int ship = filter->sampler.ships[k];
+            for (int i = 0; i < filter->sampler.count[ship]; i++) {
+                memcpy(filter->shipCells[ship][filter->sampler.placements[ship][i]], filter->sampler.masks[ship][i],
+                       sizeof(filter->shipCells[ship][0]));
+            }
+        }
+        filter->owner = bot;
+        filter->fleet = fleet;
+        filter->rng = (unsigned int)rand() * 2654435761u | 1;
+    }
+    filter->absorbed = evidence;
+    filter->turn = bot->turnNumber;
+    for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) filter->sunk[shipIdx] = fleet->ships[shipIdx].sunk;
+
+    // Reweight: ships sunk since leave every particle, then particles the evidence rules out are dropped
+    unsigned long long mustNot[CELL_MASK_WORDS];
+    unsigned long long hits[CELL_MASK_WORDS];
+    bitboardToCellMask(evidence.mustNot, mustNot);
+    bitboardToCellMask(evidence.hits, hits);
+    int survivors = 0;
+    for (int i = 0; i < filter->count; i++) {
+        Particle particle = filter->particles[i];
+        for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) {
+            if (particle.placements[shipIdx] == PLACEMENT_NONE || !fleet->ships[shipIdx].sunk) continue;
+            const unsigned long long* cells = filter->shipCells[shipIdx][particle.placements[shipIdx]];
+            for (int w = 0; w < CELL_MASK_WORDS; w++) particle.occupied[w] &= ~cells[w];
+            particle.placements[shipIdx] = PLACEMENT_NONE;
+        }
+        if (particleExplains(filter, &particle, mustNot, hits)) filter->particles[survivors++] = particle;
+    }
+    // Too few survivors would leave the resampled population a handful of copies of each other
+    if (survivors == 0) {
+        survivors = seedParticles(filter, inputs, 0, filter->capacity, deadline);
+    } else if (survivors < filter->capacity / PARTICLE_REFILL_DIVISOR) {
+        survivors = seedParticles(filter, inputs, survivors, filter->capacity / PARTICLE_REFILL_DIVISOR, deadline);
+    }
+    filter->count = survivors;
+    if (survivors == 0) return false;
+
+    // Resample back to full size: survivors weigh the same, so each is kept and the rest are uniform copies
+    for (int i = 0; i < filter->capacity; i++) {
+        filter->spare[i] = filter->particles[i < survivors ? i : (int)randomBelow(&filter->rng, (unsigned int)survivors)];
+    }
+    Particle* swap = filter->particles;
+    filter->particles = filter->spare;
+    filter->spare = swap;
+    filter->count = filter->capacity;
+
+    for (int sweep = 0; sweep < PARTICLE_SWEEPS; sweep++) {
+        for (int i = 0; i < filter->count; i++) rejuvenateParticle(filter, &filter->particles[i]);
+    }
+    return true;
+}
 
+// Adds every particle to the belief as one sampled layout
+void tallyParticles(const ParticleFilter* filter, const Fleet* fleet, Bitboard hits, BeliefSamples* belief) {
+    for (int i = 0; i < filter->count; i++) {
+        const Particle* particle = &filter->particles[i];
+        Bitboard layout[SHIP_TYPES];
+        for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) {
+            if (particle->placements[shipIdx] == PLACEMENT_NONE) {
+                memset(&layout[shipIdx], 0, sizeof(Bitboard));
+            } else {
+                layout[shipIdx] = shipPlacementMask(particle->placements[shipIdx], fleet->ships[shipIdx].size);
+            }
+        }
+        accumulateBelief(belief, layout, hits);
+    }
+}
+
+// Anytime HARD move: samples layouts until the deadline, then plays the action with the highest
+// expected number of hits over the samples, each sink it is expected to cause counting as half a
+// hit extra. Artillery and torpedo compete with the best single shot and are kept for later when
+// they would do worse. Returns false (leaving the move to the rule-based bot) if no layout could be
+// sampled in time.
+bool performAnytimeMove(Player* bot, Player* opponent, Fleet* opponentFleet, bool hardMode, double deadline,
+                        Coordinate* coord, int* result, char* sunkShipName) {
+    BeliefSamples belief;
+    if (!sampleBelief(bot, opponentFleet, deadline, &belief)) return false;
+
+    // Scores are in samples, doubled so the half-hit sink bonus stays integral
+    int bestCells[CELL_COUNT];
+    int bestCellsCount = 0;
+    int fireScore = 2 * argmaxMatchingCells(belief.cellHits, bot->trackingGrid, '~', bestCells, &bestCellsCount);
+    if (bestCellsCount == 0) return false;
+
+    Bitboard untargeted = cellMask(bot->trackingGrid, '~', '~');
+    int artilleryScore = -1;
+    Coordinate artilleryAnchor = { -1, -1 };
+    if (bot->artilleryAvailable) {
+        for (int y = 0; y < GRID_SIZE; y++) {
+            for (int x = 0; x < GRID_SIZE; x++) {
+                Bitboard footprint = bitboardAnd(windowFootprint((Coordinate){ x, y }), untargeted);
+                int score = belief.windowSinks[y][x];
+                for (int i = y; i < GRID_SIZE && i <= y + 1; i++) {
+                    for (int j = x; j < GRID_SIZE && j <= x + 1; j++) {
+                        if ((footprint.rows[i] >> j) & 1) score += 2 * belief.cellHits[i][j];
+                    }
+                }
+                if (score > artilleryScore) {
+                    artilleryScore = score;
+                    artilleryAnchor = (Coordinate){ x, y };
+                }
+            }
+        }
+    }
+
+    int torpedoScore = -1;
+    char torpedoType = 'r';
+    int torpedoIndex = -1;
+    if (bot->torpedoAvailable) {
+        for (int line = 0; line < GRID_SIZE; line++) {
+            int rowScore = belief.rowSinks[line];
+            int columnScore = belief.columnSinks[line];
+            for (int k = 0; k < GRID_SIZE; k++) {
+                if ((untargeted.rows[line] >> k) & 1) rowScore += 2 * belief.cellHits[line][k];
+                if ((untargeted.rows[k] >> line) & 1) columnScore += 2 * belief.cellHits[k][line];
+            }
+            if (rowScore > torpedoScore) {
+                torpedoScore = rowScore;
+                torpedoType = 'r';
+                torpedoIndex = line;
+            }
+            if (columnScore > torpedoScore) {
+                torpedoScore = columnScore;
+                torpedoType = 'c';
+                torpedoIndex = line;
+            }
+        }
+    }
+
+    if (torpedoScore > fireScore && torpedoScore >= artilleryScore) {
+        launchTorpedo(bot, opponent, opponentFleet, torpedoType, torpedoIndex, hardMode);
+        bot->torpedoAvailable = false;
+        return true;
+    }
+    if (artilleryScore > fireScore) {
+        *coord = artilleryAnchor;
+        gamePrintf("%s uses Artillery at %c%d\n", bot->name, 'A' + coord->x, coord->y + 1);
+        artillery(bot, opponent, opponentFleet, *coord, hardMode);
+        bot->artilleryAvailable = false;
+        return true;
+    }
+
+    int cell = bestCells[rand() % bestCellsCount];
+    *coord = (Coordinate){ cell % GRID_SIZE, cell / GRID_SIZE };
+    gamePrintf("%s fires at %c%d\n", bot->name, 'A' + coord->x, coord->y + 1);
+    *result = fire(bot, opponent, opponentFleet, *coord, hardMode, sunkShipName);
+    return true;
+}
+
+// Size of the player's next salvo: the fixed count or one shot per ship still afloat, never more
+// than the cells left to shoot at
+int salvoSize(Player* player) {
+    int shots = salvoShots == SALVO_PER_SHIP ? player->shipsRemaining : salvoShots;
+    int open = CELL_COUNT - bitboardCount(player->shotHistory);
+    if (shots > open) shots = open;
+    return shots < 1 ? 1 : shots;
+}
+
+// Resolves every shot of a salvo through the strike path before any of it is revealed, then reports
+// them together and does the bookkeeping a single shot gets. The first shot is logged as a fire
+// action and the rest as ACTION_SALVO, so a replay knows which shots share a turn.
+void fireSalvo(Player* player, Player* opponent, Fleet* opponentFleet, const Coordinate* shots, int count, bool hardMode) {
+    int results[MAX_SALVO_SHOTS];
+    char sunkShipNames[MAX_SALVO_SHOTS][20];
+
+    for (int i = 0; i < count; i++) {
+        sunkShipNames[i][0] = '\0';
+        results[i] = resolveShot(player, opponent, opponentFleet, shots[i], hardMode, sunkShipNames[i]);
+        logAction(player, i == 0 ? ACTION_FIRE : ACTION_SALVO, shots[i].y * GRID_SIZE + shots[i].x,
+                  results[i] == 1 || results[i] == 2);
+    }
+
+    for (int i = 0; i < count; i++) {
+        gamePrintf("%c%d: ", 'A' + shots[i].x, shots[i].y + 1);
+        if (results[i] == 0) {
+            gamePrintf("Miss!\n");
+        } else if (results[i] == 1) {
+            gamePrintf("Hit!\n");
+            if (player->isBot && player->difficulty != EASY) addAdjacentTargets(player, shots[i]);
+        } else if (results[i] == 2) {
+            if (player->isBot) {
+                gamePrintf("%s sunk your %s!\n", player->name, sunkShipNames[i]);
+            } else {
+                gamePrintf("Hit!\nYou sunk the opponent's %s!\n", sunkShipNames[i]);
+            }
+            unlockSpecialMoves(player, opponent);
+        } else if (results[i] == 3) {
+            gamePrintf("Already targeted this coordinate.\n");
+        }
+    }
+}
+
+// Layouts for the salvo search: the HARD bot's particles when it keeps them, otherwise fresh draws
+// until the deadline. Returns how many were gathered.
+int gatherSalvoSamples(Player* bot, Fleet* opponentFleet, double deadline, SalvoSamples* samples) {
+    static BeliefInputs inputs;
+    prepareBeliefInputs(bot, opponentFleet, &inputs);
+    unsigned long long hits[CELL_MASK_WORDS];
+    bitboardToCellMask(inputs.hits, hits);
+    samples->count = 0;
+
+    if (bot->difficulty == HARD && particleCapacity > 0) {
+        ParticleFilter* filter = particleFilterFor(bot);
+        if (updateParticleFilter(filter, bot, opponentFleet, &inputs, deadline)) {
+            for (int i = 0; i < filter->count && samples->count < SALVO_SAMPLES; i++) {
+                const Particle* particle = &filter->particles[i];
+                for (int ship = 0; ship < SHIP_TYPES; ship++) {
+                    unsigned long long* cells = samples->ships[samples->count][ship];
+                    if (particle->placements[ship] == PLACEMENT_NONE) {
+                        memset(cells, 0, sizeof(samples->ships[0][0]));
+                        continue;
+                    }
+                    for (int w = 0; w < CELL_MASK_WORDS; w++) {
+                        cells[w] = filter->shipCells[ship][particle->placements[ship]][w] & ~hits[w];
+                    }
+                }
+                samples->count++;
+            }
+            return samples->count;
+        }
+    }
+
+    unsigned int rng = (unsigned int)rand() * 2654435761u | 1;
+    int failures = 0;
+    while (samples->count < SALVO_SAMPLES) {
+        if (samples->count % BELIEF_BATCH == 0 && samples->count > 0 &&
+            !searchBudgetLeft(deadline, samples->count, HEADLESS_BELIEF_SAMPLES)) break;
+        Bitboard layout[SHIP_TYPES];
+        if (!drawBeliefSample(&inputs.set, inputs.mustCover, layout, &rng)) {
+            if (++failures >= BELIEF_GIVE_UP) break;
+            continue;
+        }
+        failures = 0;
+        for (int ship = 0; ship < SHIP_TYPES; ship++) {
+            unsigned long long* cells = samples->ships[samples->count][ship];
+            bitboardToCellMask(layout[ship], cells);
+            for (int w = 0; w < CELL_MASK_WORDS; w++) cells[w] &= ~hits[w];
+        }
+        samples->count++;
+    }
+    return samples->count;
+}
+
+// Value of adding each cell to the chosen ones, in the anytime search's doubled units: two per layout
+// with a ship on the cell, and one more per ship the cell would finish off together with the chosen
+// cells. The sink bonus is what ties a salvo's cells to each other.
+void salvoGains(const SalvoSamples* samples, const int cellHits[CELL_COUNT],
+                const unsigned long long chosen[CELL_MASK_WORDS], int gains[CELL_COUNT]) {
+    for (int cell = 0; cell < CELL_COUNT; cell++) gains[cell] = 2 * cellHits[cell];
+
+    for (int i = 0; i < samples->count; i++) {
+        for (int ship = 0; ship < SHIP_TYPES; ship++) {
+            const unsigned long long* cells = samples->ships[i][ship];
+            int left = 0;
+            int last = -1;
+            for (int w = 0; w < CELL_MASK_WORDS && left < 2; w++) {
+                unsigned long long rest = cells[w] & ~chosen[w];
+                if (rest == 0) continue;
+                left += (rest & (rest - 1)) ? 2 : 1;
+                last = w * 64;
+                while (!((rest >> (last - w * 64)) & 1)) last++;
+            }
+            if (left == 1) gains[last]++;
+        }
+    }
+}
+
+// Candidate with the largest gain that is not chosen yet, ties broken at random; -1 if none is left
+int bestSalvoCell(const int gains[CELL_COUNT], const unsigned long long candidates[CELL_MASK_WORDS],
+                  const unsigned long long chosen[CELL_MASK_WORDS], unsigned int* rng) {
+    int best = -1;
+    unsigned int ties = 0;
+    for (int cell = 0; cell < CELL_COUNT; cell++) {
+        unsigned long long bit = 1ULL << (cell % 64);
+        if (!(candidates[cell / 64] & bit) || (chosen[cell / 64] & bit)) continue;
+        if (best < 0 || gains[cell] > gains[best]) {
+            best = cell;
+            ties = 1;
+        } else if (gains[cell] == gains[best] && randomBelow(rng, ++ties) == 0) {
+            best = cell;
+        }
+    }
+    return best;
+}
+
+// Chooses the bot's salvo as a set. The top cells of the single-shot ranking are not the best set:
+// cells of one likely ship pay off together when they sink it, and cells the same layouts explain
+// add little to each other. A greedy pass adds the cell with the largest marginal gain, then a
+// correction pass swaps each chosen cell for the best one given the others until nothing improves or
+// the deadline passes. EASY's gains are all zero, so it shoots at random cells. MEDIUM stays on its
+// density grid, which stands in for the hit counts and makes the search a plain top-k; so does HARD
+// when no layout could be sampled. Returns the cells chosen.
+int chooseSalvo(Player* bot, Fleet* opponentFleet, int count, double deadline, Coordinate shots[MAX_SALVO_SHOTS]) {
+    static SalvoSamples samples;
+    int cellHits[CELL_COUNT] = { 0 };
+    int gains[CELL_COUNT];
+    int cells[MAX_SALVO_SHOTS];
+    unsigned long long candidates[CELL_MASK_WORDS];
+    unsigned long long chosen[CELL_MASK_WORDS] = { 0 };
+    unsigned int rng = (unsigned int)rand() * 2654435761u | 1;
+
+    Bitboard open = cellMask(bot->trackingGrid, '~', '~');
+    for (int y = 0; y < GRID_SIZE; y++) open.rows[y] &= (unsigned short)~bot->shotHistory.rows[y];
+    bitboardToCellMask(open, candidates);
+
+    samples.count = 0;
+    if (bot->difficulty == MEDIUM || (bot->difficulty == HARD && gatherSalvoSamples(bot, opponentFleet, deadline, &samples) == 0)) {
+        int probabilityGrid[GRID_SIZE][GRID_SIZE];
+        calculateProbabilityGrid(bot, opponentFleet, probabilityGrid);
+        for (int cell = 0; cell < CELL_COUNT; cell++) {
+            cellHits[cell] = probabilityGrid[cell / GRID_SIZE][cell % GRID_SIZE];
+        }
+    }
+    for (int i = 0; i < samples.count; i++) {
+        unsigned long long occupied[CELL_MASK_WORDS] = { 0 };
+        for (int ship = 0; ship < SHIP_TYPES; ship++) {
+            for (int w = 0; w < CELL_MASK_WORDS; w++) occupied[w] |= samples.ships[i][ship][w];
+        }
+        for (int cell = 0; cell < CELL_COUNT; cell++) {
+            if ((occupied[cell / 64] >> (cell % 64)) & 1) cellHits[cell]++;
+        }
+    }
+
+    int chosenCount = 0;
+    while (chosenCount < count) {
+        salvoGains(&samples, cellHits, chosen, gains);
+        int best = bestSalvoCell(gains, candidates, chosen, &rng);
+        if (best < 0) break;
+        cells[chosenCount++] = best;
+        chosen[best / 64] |= 1ULL << (best % 64);
+    }
+
+    bool improved = chosenCount > 1;
+    int passes = 0;
+    while (improved && searchBudgetLeft(deadline, passes++, MAX_SALVO_SHOTS)) {
+        improved = false;
+        for (int i = 0; i < chosenCount; i++) {
+            chosen[cells[i] / 64] &= ~(1ULL << (cells[i] % 64));
+            salvoGains(&samples, cellHits, chosen, gains);
+            int best = bestSalvoCell(gains, candidates, chosen, &rng);
+            if (gains[best] > gains[cells[i]]) {
+                cells[i] = best;
+                improved = true;
+            }
+            chosen[cells[i] / 64] |= 1ULL << (cells[i] % 64);
+        }
+    }
+
+    for (int i = 0; i < chosenCount; i++) {
+        shots[i].x = cells[i] % GRID_SIZE;
+        shots[i].y = cells[i] / GRID_SIZE;
+    }
+    return chosenCount;
+}
+
+// The bot's turn under salvo rules once no special move was made
+void performBotSalvo(Player* bot, Player* opponent, Fleet* opponentFleet, bool hardMode) {
+    Coordinate shots[MAX_SALVO_SHOTS];
+    int count = chooseSalvo(bot, opponentFleet, salvoSize(bot), currentTimeMs() + hardMoveBudgetMs, shots);
+    if (count == 0) {
+        gamePrintf("%s has no valid targets to fire.\n", bot->name);
+        return;
+    }
+
+    gamePrintf("%s fires a salvo at", bot->name);
+    for (int i = 0; i < count; i++) gamePrintf(" %c%d", 'A' + shots[i].x, shots[i].y + 1);
+    gamePrintf("\n");
+    fireSalvo(bot, opponent, opponentFleet, shots, count, hardMode);
+}
+
+// Opens the record of an interactive game; both sides are copied as they stand after placement
+void startGameRecord(Player* first, Player* second, Fleet* firstFleet, Fleet* secondFleet) {
+    gameRecord.players[0] = first;
+    gameRecord.players[1] = second;
+    gameRecord.opening[0] = *first;
+    gameRecord.opening[1] = *second;
+    gameRecord.openingFleets[0] = *firstFleet;
+    gameRecord.openingFleets[1] = *secondFleet;
+    gameRecord.count = 0;
+    gameRecord.active = true;
+}
+
+// Hands a resolved action to the journal and to the game record, whichever is open for the player
+void logAction(Player* player, ActionType type, int target, int outcome) {
+    GameAction action = { 0, (unsigned char)type, (unsigned char)target, (unsigned char)outcome };
+
+    if (journalSession.open && (player == journalSession.players[0] || player == journalSession.players[1])) {
+        action.side = player == journalSession.players[0] ? 0 : 1;
+        journalAppend(&journalSession, JOURNAL_ACTION, &action, sizeof(action));
+    }
+
+    if (!gameRecord.active || gameRecord.count >= MAX_GAME_ACTIONS) return;
+    if (player != gameRecord.players[0] && player != gameRecord.players[1]) return;
+    action.side = player == gameRecord.players[0] ? 0 : 1;
+    gameRecord.actions[gameRecord.count++] = action;
+}
+
+// Applies a logged action through the same move functions the game used, plus the bookkeeping the
+// bot's turn does around them. The analysis replays with hardMode off so that the tracking grids hold
+// every miss; a resumed game replays with its real setting.
+void replayAction(Player players[2], Fleet fleets[2], const GameAction* action, bool hardMode) {
+    Player* mover = &players[action->side];
+    Player* target = &players[1 - action->side];
+    Fleet* targetFleet = &fleets[1 - action->side];
+    Coordinate coord = { action->target % GRID_SIZE, action->target / GRID_SIZE };
+    char sunkShipName[20] = "";
+
+    if (mover->isBot && action->type != ACTION_SALVO) mover->turnNumber++; // Salvo shots share a turn
+
+    if (action->type == ACTION_FIRE || action->type == ACTION_SALVO) {
+        int result = resolveShot(mover, target, targetFleet, coord, hardMode, sunkShipName);
+        logAction(mover, (ActionType)action->type, action->target, result == 1 || result == 2);
+        if (result == 1 && mover->isBot && mover->difficulty != EASY) {
+            addAdjacentTargets(mover, coord);
+        } else if (result == 2) {
+            unlockSpecialMoves(mover, target);
+        }
+    } else if (action->type == ACTION_RADAR) {
+        radarSweep(mover, target, coord);
+        mover->radarSweepsUsed++;
+    } else if (action->type == ACTION_SMOKE) {
+        smokeScreen(mover, coord);
+    } else if (action->type == ACTION_ARTILLERY) {
+        artillery(mover, target, targetFleet, coord, hardMode);
+        mover->artilleryAvailable = false;
+    } else if (action->type == ACTION_TORPEDO) {
+        char line[4];
+        if (action->target < GRID_SIZE) {
+            snprintf(line, sizeof(line), "%d", action->target + 1);
+        } else {
+            line[0] = (char)('a' + action->target - GRID_SIZE);
+            line[1] = '\0';
+        }
+        torpedo(mover, target, targetFleet, line, hardMode);
+        mover->torpedoAvailable = false;
+    }
+}
+
+// Short text for an action, e.g. "fire C5" or "torpedo col D"; text needs room for 24 characters
+void describeAction(const GameAction* action, char* text) {
+    static const char* names[] = { "fire", "radar", "smoke", "artillery", "torpedo", "salvo" };
+    if (action->type == ACTION_TORPEDO) {
+        if (action->target < GRID_SIZE) {
+            snprintf(text, 24, "torpedo row %d", action->target + 1);
+        } else {
+            snprintf(text, 24, "torpedo col %c", 'A' + action->target - GRID_SIZE);
+        }
+    } else {
+        snprintf(text, 24, "%s %c%d", names[action->type], 'A' + action->target % GRID_SIZE,
+                 action->target / GRID_SIZE + 1);
+    }
+}
+
+// Cells an action fires at, restricted to the untargeted ones; for radar the cells it sweeps
+Bitboard actionArea(const GameAction* action, Bitboard untargeted) {
+    Bitboard area = { { 0 } };
+    Coordinate coord = { action->target % GRID_SIZE, action->target / GRID_SIZE };
+
+    if (action->type == ACTION_FIRE || action->type == ACTION_SALVO) {
+        area.rows[coord.y] = (unsigned short)(1 << coord.x);
+    } else if (action->type == ACTION_RADAR) {
+        return windowFootprint(coord);
+    } else if (action->type == ACTION_ARTILLERY) {
+        area = windowFootprint(coord);
+    } else if (action->type == ACTION_TORPEDO) {
+        for (int y = 0; y < GRID_SIZE; y++) {
+            if (action->target < GRID_SIZE) {
+                if (y == action->target) area.rows[y] = FULL_ROW;
+            } else {
+                area.rows[y] = (unsigned short)(1 << (action->target - GRID_SIZE));
+            }
+        }
+    }
+    return bitboardAnd(area, untargeted); // Smoke fires at nothing
+}
+
+// Scores one move against layouts sampled from the mover's knowledge before it: the expected hits
+// of the move played, the best fire, artillery or torpedo the mover had (radar and smoke score no
+// hits) and the share of layouts in which the move comes out exactly as it did
+void analyzeMove(MoveAnalysis* move, unsigned int rng) {
+    BeliefInputs inputs;
+    prepareBeliefInputs(&move->view, &move->targetFleet, &inputs);
+    Bitboard untargeted = cellMask(move->view.trackingGrid, '~', '~');
+    Bitboard known = cellMask(move->view.trackingGrid, '*', '*');
+    bool salvo = move->action.type == ACTION_SALVO;
+    Bitboard area = salvo ? bitboardAnd(move->salvo, untargeted) : actionArea(&move->action, untargeted);
+    bool radar = move->action.type == ACTION_RADAR;
+
+    int cellHits[GRID_SIZE][GRID_SIZE] = { { 0 } };
+    int matches = 0;
+    int failures = 0;
+    move->samples = 0;
+    while (move->samples < ANALYSIS_SAMPLES && failures < BELIEF_GIVE_UP) {
+        Bitboard layout[SHIP_TYPES];
+        if (!drawBeliefSample(&inputs.set, inputs.mustCover, layout, &rng)) {
+            failures++;
+            continue;
+        }
+        failures = 0;
+        move->samples++;
+
+        Bitboard occupied = known;
+        for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) {
+            for (int y = 0; y < GRID_SIZE; y++) occupied.rows[y] |= layout[shipIdx].rows[y];
+        }
+        Bitboard fresh = bitboardAnd(occupied, untargeted);
+        for (int y = 0; y < GRID_SIZE; y++) {
+            for (unsigned int bits = fresh.rows[y]; bits; bits &= bits - 1) {
+                int x = 0;
+                while (!((bits >> x) & 1)) x++;
+                cellHits[y][x]++;
+            }
+        }
+
+        int hits = bitboardCount(bitboardAnd(occupied, area));
+        if (radar) hits = hits > 0;
+        if (hits == move->action.outcome || (radar && move->action.outcome == 2)) matches++;
+    }
+    if (move->samples == 0) return;
+
+    double scale = 1.0 / move->samples;
+    int played = 0;
+    for (int y = 0; y < GRID_SIZE; y++) {
+        for (int x = 0; x < GRID_SIZE; x++) {
+            if (!radar && ((area.rows[y] >> x) & 1)) played += cellHits[y][x];
+        }
+    }
+    move->expectedHits = played * scale;
+    move->luck = matches * scale;
+
+    // Expected hits add up over cells, so the best salvo of the same size is its most likely cells
+    if (salvo) {
+        Bitboard open = untargeted;
+        int shots = bitboardCount(move->salvo);
+        int bestScore = 0;
+        move->best = (GameAction){ move->action.side, ACTION_SALVO, 0, 0 };
+        for (int shot = 0; shot < shots; shot++) {
+            int bestCell = -1;
+            int bestCellHits = -1;
+            for (int cell = 0; cell < CELL_COUNT; cell++) {
+                int x = cell % GRID_SIZE;
+                int y = cell / GRID_SIZE;
+                if (((open.rows[y] >> x) & 1) && cellHits[y][x] > bestCellHits) {
+                    bestCell = cell;
+                    bestCellHits = cellHits[y][x];
+                }
+            }
+            if (bestCell < 0) break;
+            if (shot == 0) move->best.target = (unsigned char)bestCell;
+            open.rows[bestCell / GRID_SIZE] &= (unsigned short)~(1 << (bestCell % GRID_SIZE));
+            bestScore += bestCellHits;
+        }
+        move->bestHits = bestScore * scale;
+        return;
+    }
+
+    // Candidates come from the legal move generator in ActionType order and a later one must be
+    // strictly better, so ties go to the plain shot
+    ActionCode actions[MAX_LEGAL_ACTIONS];
+    int actionCount = generateLegalActions(&move->view, actions);
+    int bestScore = -1;
+    for (int i = 0; i < actionCount; i++) {
+        GameAction candidate = { move->action.side, (unsigned char)ACTION_CODE_TYPE(actions[i]),
+                                 (unsigned char)ACTION_CODE_TARGET(actions[i]), 0 };
+        if (candidate.type == ACTION_RADAR || candidate.type == ACTION_SMOKE) continue;
+
+        Bitboard footprint = actionArea(&candidate, untargeted);
+        int score = 0;
+        for (int y = 0; y < GRID_SIZE; y++) {
+            for (unsigned int bits = footprint.rows[y]; bits; bits &= bits - 1) {
+                int x = 0;
+                while (!((bits >> x) & 1)) x++;
+                score += cellHits[y][x];
+            }
+        }
+        if (score > bestScore) {
+            bestScore = score;
+            move->best = candidate;
+        }
+    }
+    move->bestHits = bestScore < 0 ? 0.0 : bestScore * scale;
+}
+
+// Each move gets its own seed, so the report does not depend on how moves are split over threads
+void* analysisThread(void* arg) {
+    AnalysisWorker* worker = (AnalysisWorker*)arg;
+    for (int i = worker->first; i < worker->count; i += worker->stride) {
+        analyzeMove(&worker->moves[i], (unsigned int)(i + 1) * 2654435761u | 1);
+    }
+    return NULL;
+}
+
+// Replays the recorded game to recover each mover's knowledge before every move, then scores the
+// moves on all cores; the moves are independent once their positions are known
+void analyzeGame() {
+    static Player players[2];
+    static Fleet fleets[2];
+    static MoveAnalysis moves[MAX_GAME_ACTIONS];
+    bool wasQuiet = quietMode;
+    double start = currentTimeMs();
+
+    gameRecord.active = false;
+    quietMode = true;
+    int moveCounts[2] = { 0, 0 };
+    int count = 0;
+    for (int side = 0; side < 2; side++) {
+        players[side] = gameRecord.opening[side];
+        fleets[side] = gameRecord.openingFleets[side];
+    }
+    for (int i = 0; i < gameRecord.count; i++) {
+        const GameAction* action = &gameRecord.actions[i];
+        MoveAnalysis* move = count > 0 ? &moves[count - 1] : NULL;
+        Coordinate coord = { action->target % GRID_SIZE, action->target / GRID_SIZE };
+        if (action->type == ACTION_SALVO && move && move->action.side == action->side) {
+            // Later shots of a salvo join its first one, scored from the knowledge before the turn
+            move->action.type = ACTION_SALVO;
+            move->action.outcome = (unsigned char)(move->action.outcome + action->outcome);
+            move->salvo.rows[coord.y] |= (unsigned short)(1 << coord.x);
+        } else {
+            move = &moves[count++];
+            move->view = players[action->side];
+            move->targetFleet = fleets[1 - action->side];
+            move->action = *action;
+            memset(&move->salvo, 0, sizeof(move->salvo));
+            move->salvo.rows[coord.y] = (unsigned short)(1 << coord.x);
+            move->moveNumber = ++moveCounts[action->side];
+        }
+        replayAction(players, fleets, action, false);
+    }
+    quietMode = wasQuiet;
+
+    int threads = 1;
+#ifndef _WIN32
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cores < 1 ? 1 : (cores > MAX_ANALYSIS_THREADS ? MAX_ANALYSIS_THREADS : (int)cores);
+    if (threads > count) threads = count > 0 ? count : 1;
+#endif
+    AnalysisWorker workers[MAX_ANALYSIS_THREADS];
+    for (int t = 0; t < threads; t++) {
+        workers[t] = (AnalysisWorker){ moves, count, t, threads };
+    }
+#ifndef _WIN32
+    pthread_t handles[MAX_ANALYSIS_THREADS];
+    bool started[MAX_ANALYSIS_THREADS] = { false };
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&handles[t], NULL, analysisThread, &workers[t]) == 0;
+    }
+    analysisThread(&workers[0]);
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) {
+            pthread_join(handles[t], NULL);
+        } else {
+            analysisThread(&workers[t]);
+        }
+    }
+#else
+    analysisThread(&workers[0]);
+#endif
+
+    printAnalysisReport(moves, count, currentTimeMs() - start);
+}
+
+// Per side: how often the move played was the engine's, the expected hits given up, actual against
+// expected hits (luck) and the three costliest moves
+void printAnalysisReport(MoveAnalysis* moves, int count, double elapsedMs) {
+    printf("\nPost-game analysis (%d moves, %d layouts each, %.0f ms)\n", count, ANALYSIS_SAMPLES, elapsedMs);
+    for (int side = 0; side < 2; side++) {
+        int analysed = 0;
+        int matched = 0;
+        int unlikely = 0;
+        int hits = 0;
+        double expected = 0.0;
+        double lost = 0.0;
+        int worst[3] = { -1, -1, -1 };
+
+        for (int i = 0; i < count; i++) {
+            MoveAnalysis* move = &moves[i];
+            if (move->action.side != side || move->samples == 0) continue;
+            double loss = move->bestHits - move->expectedHits;
+            analysed++;
+            if (loss < 1e-9) matched++;
+            if (move->luck < 0.1) unlikely++;
+            if (move->action.type != ACTION_RADAR) hits += move->action.outcome;
+            expected += move->expectedHits;
+            lost += loss;
+
+            for (int k = 0; k < 3; k++) {
+                if (worst[k] == -1 || loss > moves[worst[k]].bestHits - moves[worst[k]].expectedHits) {
+                    for (int j = 2; j > k; j--) worst[j] = worst[j - 1];
+                    worst[k] = i;
+                    break;
+                }
+            }
+        }
+
+        printf("%s: %d moves analysed, %d matched the engine, %.2f expected hits given up\n",
+               gameRecord.players[side]->name, analysed, matched, lost);
+        printf("  %d hits against %.2f expected, %d outcomes with under 10%% chance\n", hits, expected, unlikely);
+        for (int k = 0; k < 3 && worst[k] != -1; k++) {
+            MoveAnalysis* move = &moves[worst[k]];
+            if (move->bestHits - move->expectedHits < 1e-9) break;
+            char played[24];
+            char best[24];
+            describeAction(&move->action, played);
+            describeAction(&move->best, best);
+            printf("  Move %d: %s (%.2f expected hits), engine: %s (%.2f)\n",
+                   move->moveNumber, played, move->expectedHits, best, move->bestHits);
+        }
+    }
+}
+
+// Opens (or creates) the journal for appending. A record torn by a crash mid-write is cut off so new
+// records line up again, and session ids continue after the highest one in the file.
+bool openJournal(const char* path) {
+#ifndef _WIN32
+    if (journal.fd >= 0) {
+        commitJournal();
+        close(journal.fd);
+        journal.fd = -1;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) return false;
+
+    size_t size = 0;
+    size_t valid = 0;
+    const unsigned char* data = (const unsigned char*)mapReadOnlyFile(path, &size);
+    journal.nextSession = 1;
+    if (data) {
+        JournalHeader header;
+        const unsigned char* payload;
+        while (readJournalRecord(data, size, &valid, &header, &payload)) {
+            if (header.session >= journal.nextSession) journal.nextSession = header.session + 1;
+        }
+        munmap((void*)data, size);
+    }
+    if (valid < size && ftruncate(fd, (off_t)valid) != 0) {
+        close(fd);
+        return false;
+    }
+
+    journal.fd = fd;
+    journal.pending = 0;
+    return true;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+// Reads the record at *offset and moves past it. Returns false at the end of the data or at a record
+// that is cut short or malformed, which only a crash mid-write leaves behind.
+bool readJournalRecord(const unsigned char* data, size_t size, size_t* offset, JournalHeader* header,
+                       const unsigned char** payload) {
+    static const int lengths[] = { sizeof(JournalOpening), sizeof(GameAction), 0 };
+    if (size - *offset < sizeof(JournalHeader)) return false;
+    memcpy(header, data + *offset, sizeof(JournalHeader));
+    if (header->kind > JOURNAL_CLOSE || header->length != lengths[header->kind]) return false;
+    if (size - *offset - sizeof(JournalHeader) < header->length) return false;
+
+    *payload = data + *offset + sizeof(JournalHeader);
+    *offset += sizeof(JournalHeader) + header->length;
+    return true;
+}
+
+void journalAppend(JournalSession* session, JournalRecordKind kind, const void* payload, int length) {
+#ifndef _WIN32
+    if (journal.fd < 0) return;
+
+    unsigned char record[sizeof(JournalHeader) + sizeof(JournalOpening)];
+    JournalHeader header = { session->id, (unsigned char)kind, (unsigned char)length, 0 };
+    memcpy(record, &header, sizeof(header));
+    memcpy(record + sizeof(header), payload, (size_t)length);
+
+    // One write per record: with O_APPEND it lands whole and in order, and a crash can only tear the tail
+    ssize_t size = (ssize_t)(sizeof(header) + (size_t)length);
+    if (write(journal.fd, record, (size_t)size) != size) {
+        printf("Journal write failed; journaling is off for the rest of this run.\n");
+        close(journal.fd);
+        journal.fd = -1;
+        return;
+    }
+
+    double now = currentTimeMs();
+    if (journal.pending++ == 0) journal.oldestPending = now;
+    if (journal.pending >= JOURNAL_GROUP_RECORDS || now - journal.oldestPending >= JOURNAL_COMMIT_MS) {
+        commitJournal();
+    }
+#else
+    (void)session;
+    (void)kind;
+    (void)payload;
+    (void)length;
+#endif
+}
+
+// Group commit: one fsync makes every record written so far durable, whichever session wrote it
+void commitJournal() {
+#ifndef _WIN32
+    if (journal.fd < 0 || journal.pending == 0) return;
+    fsync(journal.fd);
+    journal.pending = 0;
+#endif
+}
+
+void beginJournalSession(JournalSession* session, Player* first, Player* second, Fleet* firstFleet,
+                         Fleet* secondFleet, bool hardMode) {
+    session->open = false;
+    if (journal.fd < 0) return;
+
+    JournalOpening opening;
+    memset(&opening, 0, sizeof(opening));
+    Player* players[2] = { first, second };
+    Fleet* fleets[2] = { firstFleet, secondFleet };
+    opening.flags = hardMode ? 4 : 0;
+    for (int side = 0; side < 2; side++) {
+        memcpy(opening.names[side], players[side]->name, MAX_NAME_LENGTH);
+        opening.difficulty[side] = (unsigned char)players[side]->difficulty;
+        if (players[side]->isBot) opening.flags |= (unsigned char)(1 << side);
+        for (int i = 0; i < SHIP_TYPES; i++) {
+            Ship* ship = &fleets[side]->ships[i];
+            opening.placements[side][i] = (unsigned char)((ship->position.y * GRID_SIZE + ship->position.x) |
+                                                          (ship->orientation == 'v' ? 0x80 : 0));
+        }
+    }
+
+    session->id = journal.nextSession++;
+    session->players[0] = first;
+    session->players[1] = second;
+    session->open = true;
+    journalAppend(session, JOURNAL_OPEN, &opening, sizeof(opening));
+}
+
+void endJournalSession(JournalSession* session) {
+    if (!session->open) return;
+    journalAppend(session, JOURNAL_CLOSE, NULL, 0);
+    commitJournal();
+    session->open = false;
+}
+
+// Rebuilds a journaled game from its opening and actions and continues it where it stopped. The side
+// to move is the one that did not make the last action, so a turn forfeited by invalid input right
+// before the crash is given back.
+bool resumeSession(unsigned int id, const char* path) {
+    static Player players[2];
+    static Fleet fleets[2];
+    bool hardMode = false;
+    bool found = false;
+    bool closed = false;
+    int lastSide = 1;
+
+    if (!openJournal(path)) {
+        printf("Could not open journal %s.\n", path);
+        return false;
+    }
+    size_t size = 0;
+    const unsigned char* data = (const unsigned char*)mapReadOnlyFile(path, &size);
+
+    bool wasQuiet = quietMode;
+    quietMode = true;
+    size_t offset = 0;
+    JournalHeader header;
+    const unsigned char* payload;
+    while (data && readJournalRecord(data, size, &offset, &header, &payload)) {
+        if (header.session != id) continue;
+
+        if (header.kind == JOURNAL_OPEN) {
+            JournalOpening opening;
+            memcpy(&opening, payload, sizeof(opening));
+            hardMode = (opening.flags & 4) != 0;
+            for (int side = 0; side < 2; side++) {
+                initializePlayer(&players[side], (opening.flags & (1 << side)) != 0,
+                                 (DifficultyLevel)opening.difficulty[side]);
+                memcpy(players[side].name, opening.names[side], MAX_NAME_LENGTH);
+                players[side].name[MAX_NAME_LENGTH - 1] = '\0';
+                initializeFleet(&fleets[side]);
+                for (int i = 0; i < SHIP_TYPES; i++) {
+                    Ship* ship = &fleets[side].ships[i];
+                    unsigned char placement = opening.placements[side][i];
+                    ship->position = (Coordinate){ (placement & 0x7F) % GRID_SIZE, (placement & 0x7F) / GRID_SIZE };
+                    ship->orientation = (placement & 0x80) ? 'v' : 'h';
+                    placeShipOnGrid(players[side].grid, ship->position, ship->size, ship->orientation, ship->symbol);
+                }
+            }
+            if (analysisEnabled) startGameRecord(&players[0], &players[1], &fleets[0], &fleets[1]);
+            found = true;
+        } else if (header.kind == JOURNAL_ACTION && found) {
+            GameAction action;
+            memcpy(&action, payload, sizeof(action));
+            replayAction(players, fleets, &action, hardMode);
+            lastSide = action.side;
+        } else if (header.kind == JOURNAL_CLOSE) {
+            closed = true;
+        }
+    }
+    quietMode = wasQuiet;
+#ifndef _WIN32
+    if (data) munmap((void*)data, size);
+#endif
+
+    if (!found) {
+        printf("Session %u is not in %s.\n", id, path);
+        return false;
+    }
+    if (closed) {
+        printf("Session %u has already finished.\n", id);
+        return false;
+    }
+
+    journalSession.open = true;
+    journalSession.id = id;
+    journalSession.players[0] = &players[0];
+    journalSession.players[1] = &players[1];
+    printf("Resuming session %u: %s against %s.\n", id, players[0].name, players[1].name);
+
+    int next = 1 - lastSide;
+    gameLoop(&players[next], &players[1 - next], &fleets[next], &fleets[1 - next], hardMode);
+    return true;
+}
+
+// Creates (or reattaches to) the broadcast channel. Sequence numbers carry on across games and
+// restarts, so attached viewers never see them go backwards. The channel has a single writer: an
+// exclusive lock on the shared-memory object, held until exit, keeps a second broadcaster out.
+bool openSpectatorChannel() {
+#ifndef _WIN32
+    int fd = shm_open(SPECTATOR_CHANNEL, O_RDWR | O_CREAT, 0644);
+    if (fd < 0) return false;
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+        printf("Another game is already broadcasting on %s.\n", SPECTATOR_CHANNEL);
+        close(fd);
+        return false;
+    }
+    if (ftruncate(fd, sizeof(SpectatorChannel)) != 0) {
+        close(fd);
+        return false;
+    }
+    void* mapped = mmap(NULL, sizeof(SpectatorChannel), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        close(fd);
+        return false;
+    }
+    spectatorLockFd = fd;
+
+    spectatorChannel = (SpectatorChannel*)mapped;
+    if (memcmp(spectatorChannel->magic, SPECTATOR_MAGIC, sizeof(spectatorChannel->magic)) != 0) {
+        memset(spectatorChannel, 0, sizeof(SpectatorChannel));
+        memcpy(spectatorChannel->magic, SPECTATOR_MAGIC, sizeof(spectatorChannel->magic));
+    }
+    // A producer that died mid-update leaves the seqlock odd, which would stall every reader
+    unsigned int version = __atomic_load_n(&spectatorChannel->snapshotVersion, __ATOMIC_RELAXED);
+    if (version & 1) __atomic_store_n(&spectatorChannel->snapshotVersion, version + 1, __ATOMIC_RELEASE);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void beginBroadcast(Player* first, Player* second) {
+    if (!spectatorChannel) return;
+    broadcastPlayers[0] = first;
+    broadcastPlayers[1] = second;
+    broadcastEvent(first, SPECTATE_NEW_GAME, (Coordinate){ 0, 0 }, 0);
+}
+
+// Publishes one event with a handful of stores into shared memory: no system call, no lock, and
+// nothing that depends on how many viewers there are or how far behind they are
+void broadcastEvent(Player* player, SpectatorEventKind kind, Coordinate coord, int ship) {
+    SpectatorChannel* channel = spectatorChannel;
+    if (!channel || (player != broadcastPlayers[0] && player != broadcastPlayers[1])) return;
+#ifndef _WIN32
+    int side = player == broadcastPlayers[0] ? 0 : 1;
+    SpectatorEvent event = { channel->head + 1, (unsigned char)kind, (unsigned char)side,
+                             (unsigned char)(coord.y * GRID_SIZE + coord.x), (unsigned char)ship };
+
+    // Snapshot first, so a viewer resyncing from it never lands past an event it lacks
+    unsigned int version = channel->snapshotVersion;
+    __atomic_store_n(&channel->snapshotVersion, version + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    if (kind == SPECTATE_NEW_GAME) {
+        for (int i = 0; i < 2; i++) {
+            memcpy(channel->snapshot.names[i], broadcastPlayers[i]->name, MAX_NAME_LENGTH);
+            memcpy(channel->snapshot.grids[i], broadcastPlayers[i]->grid, sizeof(channel->snapshot.grids[i]));
+        }
+        channel->snapshot.lastEvent = event.sequence;
+        channel->opening = channel->snapshot;
+    } else if (kind != SPECTATE_WIN) {
+        channel->snapshot.grids[1 - side][coord.y][coord.x] = kind == SPECTATE_MISS ? 'o' : 'X';
+    }
+    channel->snapshot.lastEvent = event.sequence;
+    __atomic_store_n(&channel->snapshotVersion, version + 2, __ATOMIC_RELEASE);
+
+    unsigned long long word;
+    memcpy(&word, &event, sizeof(word));
+    __atomic_store_n(&channel->ring[event.sequence % SPECTATOR_RING_SLOTS], word, __ATOMIC_RELEASE);
+    __atomic_store_n(&channel->head, event.sequence, __ATOMIC_RELEASE);
+#endif
+}
+
+// Seqlock read: copies one of the channel's snapshots and retries if the producer changed it meanwhile
+bool readSpectatorSnapshot(const SpectatorChannel* channel, const SpectatorSnapshot* source, SpectatorSnapshot* copy) {
+#ifndef _WIN32
+    for (int attempt = 0; attempt < 1000; attempt++) {
+        unsigned int before = __atomic_load_n(&channel->snapshotVersion, __ATOMIC_ACQUIRE);
+        if (before & 1) continue;
+        memcpy(copy, source, sizeof(*copy));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&channel->snapshotVersion, __ATOMIC_RELAXED) == before) return true;
+    }
+#else
+    (void)channel;
+    (void)source;
+    (void)copy;
+#endif
+    return false;
+}
+
+void showSpectatorView(const SpectatorSnapshot* snapshot, const char* lastEvent) {
+    clearScreen();
+    for (int side = 0; side < 2; side++) {
+        char grid[GRID_SIZE][GRID_SIZE];
+        memcpy(grid, snapshot->grids[side], sizeof(grid));
+        printf("%s's fleet:\n", snapshot->names[side]);
+        displayGrid(grid, true);
+    }
+    printf("%s\n", lastEvent);
+    fflush(stdout);
+}
+
+// Viewer process: maps the channel read-only, starts from the snapshot and then follows the ring.
+// Falling a whole ring behind shows up as a slot with a newer sequence than expected, and the
+// viewer simply resyncs from the snapshot; the game never knows it is being watched.
+void spectate() {
+#ifndef _WIN32
+    const SpectatorChannel* channel = NULL;
+    printf("Waiting for a game to broadcast on %s...\n", SPECTATOR_CHANNEL);
+    while (!channel) {
+        int fd = shm_open(SPECTATOR_CHANNEL, O_RDONLY, 0);
+        if (fd >= 0) {
+            struct stat info;
+            if (fstat(fd, &info) == 0 && (size_t)info.st_size >= sizeof(SpectatorChannel)) {
+                void* mapped = mmap(NULL, sizeof(SpectatorChannel), PROT_READ, MAP_SHARED, fd, 0);
+                if (mapped != MAP_FAILED) channel = (const SpectatorChannel*)mapped;
+            }
+            close(fd);
+        }
+        if (channel && memcmp(channel->magic, SPECTATOR_MAGIC, sizeof(channel->magic)) != 0) {
+            munmap((void*)channel, sizeof(SpectatorChannel));
+            channel = NULL;
+        }
+        if (!channel) usleep(500 * 1000);
+    }
+
+    SpectatorSnapshot snapshot;
+    char lastEvent[96] = "Waiting for the next move...";
+    unsigned int next = 0;
+    bool synced = false;
+    while (true) {
+        if (!synced) {
+            if (!readSpectatorSnapshot(channel, &channel->snapshot, &snapshot)) {
+                usleep(SPECTATOR_POLL_MS * 1000);
+                continue;
+            }
+            next = snapshot.lastEvent + 1;
+            synced = true;
+            showSpectatorView(&snapshot, lastEvent);
+        }
+
+        unsigned long long word = __atomic_load_n(&channel->ring[next % SPECTATOR_RING_SLOTS], __ATOMIC_ACQUIRE);
+        SpectatorEvent event;
+        memcpy(&event, &word, sizeof(event));
+        if (event.sequence != next) {
+            if ((int)(event.sequence - next) > 0) {
+                snprintf(lastEvent, sizeof(lastEvent), "Fell %u events behind; resynced.",
+                         __atomic_load_n(&channel->head, __ATOMIC_ACQUIRE) - next + 1);
+                synced = false;
+            } else {
+                usleep(SPECTATOR_POLL_MS * 1000);
+            }
+            continue;
+        }
+        next++;
+
+        const char* shooter = snapshot.names[event.side];
+        int x = event.cell % GRID_SIZE;
+        int y = event.cell / GRID_SIZE;
+        if (event.kind == SPECTATE_NEW_GAME) {
+            // Follow the new game from its first move, unless yet another one has started since
+            SpectatorSnapshot opening;
+            snprintf(lastEvent, sizeof(lastEvent), "%s", "A new game has started.");
+            if (!readSpectatorSnapshot(channel, &channel->opening, &opening) || opening.lastEvent != event.sequence) {
+                synced = false;
+                continue;
+            }
+            snapshot = opening;
+        } else if (event.kind == SPECTATE_MISS) {
+            snapshot.grids[1 - event.side][y][x] = 'o';
+            snprintf(lastEvent, sizeof(lastEvent), "%s fires at %c%d: miss.", shooter, 'A' + x, y + 1);
+        } else if (event.kind == SPECTATE_HIT) {
+            snapshot.grids[1 - event.side][y][x] = 'X';
+            snprintf(lastEvent, sizeof(lastEvent), "%s fires at %c%d: hit!", shooter, 'A' + x, y + 1);
+        } else if (event.kind == SPECTATE_SINK) {
+            snapshot.grids[1 - event.side][y][x] = 'X';
+            snprintf(lastEvent, sizeof(lastEvent), "%s fires at %c%d and sinks the %s!", shooter, 'A' + x, y + 1,
+                     defaultShips[event.ship % SHIP_TYPES].name);
+        } else if (event.kind == SPECTATE_WIN) {
+            snprintf(lastEvent, sizeof(lastEvent), "%s wins!", shooter);
+        }
+        showSpectatorView(&snapshot, lastEvent);
+    }
+#else
+    printf("Spectating needs POSIX shared memory.\n");
+#endif
+}
+
+// Smokes the window the opponent is most likely to sweep with radar: the one whose unhit ship cells
+// carry the most weight in the opponent's own density over our board. Ties go to the window hiding
+// the most ship cells.
+Coordinate getSmokeScreenCoordinateForBot(Player* bot, Player* opponent) {
+    updateThreatMap(bot, opponent);
+
+    Coordinate best = { -1, -1 };
+    int bestExposure = 0;
+    int bestCells = 0;
+    Bitboard ships = cellMask(bot->grid, 'A', 'Z');
+    Bitboard covering = windowAny(ships);
+    WindowCounts shipCells = windowCount(ships);
+    for (int y = 0; y < GRID_SIZE; y++) {
+        for (int x = 0; x < GRID_SIZE; x++) {
+            if (!((covering.rows[y] >> x) & 1)) continue;
+            int cells = windowCountAt(&shipCells, x, y);
+
+            int exposure = bot->threat.exposure[y][x];
+            if (exposure > bestExposure || (exposure == bestExposure && cells > bestCells)) {
+                bestExposure = exposure;
+                bestCells = cells;
+                best = (Coordinate){ x, y };
+            }
+        }
+    }
+    return best;
+}
+
+// Fleet status as far as the grid tells: a ship is sunk once none of its cells is left unhit
+void deriveFleetView(char grid[GRID_SIZE][GRID_SIZE], Fleet* fleet) {
+    initializeFleet(fleet);
+    for (int i = 0; i < SHIP_TYPES; i++) {
+        int unhit = 0;
+        for (int y = 0; y < GRID_SIZE; y++) {
+            for (int x = 0; x < GRID_SIZE; x++) {
+                if (grid[y][x] == fleet->ships[i].symbol) unhit++;
+            }
+        }
+        fleet->ships[i].hits = fleet->ships[i].size - unhit;
+        updateShipStatus(&fleet->ships[i]);
+    }
+}
+
+// Runs the density model from the opponent's seat (its tracking grid, resolved hits and parameters
+// against our fleet) and folds it into per-window exposure. After the first build, only placements
+// crossing a cell that changed in the opponent's view are taken back and re-added, and only cells
+// whose exposed density moved touch their four windows. A sink (which changes the ships that count)
+// or the opponent leaving its parity hunt (which changes the cells credited) rebuilds from scratch.
+void updateThreatMap(Player* bot, Player* opponent) {
+    ThreatMap* threat = &bot->threat;
+    char view[GRID_SIZE][GRID_SIZE];
+    densityView(opponent, view);
+    bool parityHunt = !anyCellMatches(view, '*') && opponent->params->checkerboardHunt;
+
+    // Unhit ship cells not already behind an active smoke screen
+    Bitboard exposed = cellMask(bot->grid, 'A', 'Z');
+    for (int i = 0; i < bot->smokeScreensUsed; i++) {
+        if (!bot->smokeScreens[i].active) continue;
+        Bitboard smoke = windowFootprint(bot->smokeScreens[i].coord);
+        for (int y = 0; y < GRID_SIZE; y++) {
+            exposed.rows[y] &= (unsigned short)~smoke.rows[y];
+        }
+    }
+
+    if (!threat->valid || threat->shipsSunk != opponent->shipsSunk || threat->parityHunt != parityHunt) {
+        deriveFleetView(bot->grid, &threat->fleetView);
+        calculateProbabilityGrid(opponent, &threat->fleetView, threat->density);
+        memset(threat->exposure, 0, sizeof(threat->exposure));
+        for (int y = 0; y < GRID_SIZE; y++) {
+            for (int x = 0; x < GRID_SIZE; x++) {
+                if ((exposed.rows[y] >> x) & 1) addThreatExposure(threat, x, y, threat->density[y][x]);
+            }
+        }
+    } else {
+        Bitboard changed = { { 0 } };
+        unsigned short changedColumns[GRID_SIZE] = { 0 };
+        bool any = memcmp(&exposed, &threat->exposed, sizeof(exposed)) != 0;
+        for (int y = 0; y < GRID_SIZE; y++) {
+            for (int x = 0; x < GRID_SIZE; x++) {
+                if (view[y][x] == threat->view[y][x]) continue;
+                changed.rows[y] |= (unsigned short)(1 << x);
+                changedColumns[x] |= (unsigned short)(1 << y);
+                any = true;
+            }
+        }
+        if (!any) return;
+
+        int delta[GRID_SIZE][GRID_SIZE] = { { 0 } };
+        for (int shipIdx = 0; shipIdx < SHIP_TYPES; shipIdx++) {
+            Ship* ship = &threat->fleetView.ships[shipIdx];
+            if (ship->sunk) continue;
+            unsigned short run = (unsigned short)((1 << ship->size) - 1);
+            for (int vertical = 0; vertical <= 1; vertical++) {
+                for (int line = 0; line < GRID_SIZE; line++) {
+                    unsigned short lineChanged = vertical ? changedColumns[line] : changed.rows[line];
+                    if (!lineChanged) continue;
+                    for (int start = 0; start <= GRID_SIZE - ship->size; start++) {
+                        if (!(lineChanged & (run << start))) continue;
+                        int x = vertical ? line : start;
+                        int y = vertical ? start : line;
+                        accumulatePlacement(opponent, threat->view, parityHunt, shipIdx, ship->size, vertical, x, y, -1, delta);
+                        accumulatePlacement(opponent, view, parityHunt, shipIdx, ship->size, vertical, x, y, 1, delta);
+                    }
+                }
+            }
+        }
+
+        for (int y = 0; y < GRID_SIZE; y++) {
+            for (int x = 0; x < GRID_SIZE; x++) {
+                int before = ((threat->exposed.rows[y] >> x) & 1) ? threat->density[y][x] : 0;
+                threat->density[y][x] += delta[y][x];
+                int after = ((exposed.rows[y] >> x) & 1) ? threat->density[y][x] : 0;
+                if (after != before) addThreatExposure(threat, x, y, after - before);
+            }
+        }
+    }
+
+    memcpy(threat->view, view, sizeof(view));
+    threat->shipsSunk = opponent->shipsSunk;
+    threat->parityHunt = parityHunt;
+    threat->exposed = exposed;
+    threat->valid = true;
+}
+
+// Credits a cell's exposed density to the (up to four) windows anchored on or just above/left of it
+void addThreatExposure(ThreatMap* threat, int x, int y, int amount) {
+    for (int ay = y - 1; ay <= y; ay++) {
+        for (int ax = x - 1; ax <= x; ax++) {
+            if (ax >= 0 && ay >= 0) threat->exposure[ay][ax] += amount;
+        }
+    }
+}
+
+void handleEdgeCoordinates(int* start, int* end) {
+    if (*start < 0) *start = 0;
+    if (*end >= GRID_SIZE) *end = GRID_SIZE - 1;
+}
+
+void gamePrintf(const char* format, ...) {
+    if (quietMode) return;
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+}
+
+void waitForEnter() {
+    if (quietMode) return;
+    printf("Press Enter to continue...");
+    getchar();
+}
+
+void initializeFleet(Fleet* fleet) {
+    memcpy(fleet->ships, defaultShips, sizeof(defaultShips));
+}
+
+DifficultyLevel parseDifficulty(const char* input, DifficultyLevel fallback) {
+    char level[MAX_INPUT_LENGTH];
+    strncpy(level, input, sizeof(level) - 1);
+    level[sizeof(level) - 1] = '\0';
+    toLowerCase(level);
+    if (strcmp(level, "easy") == 0) return EASY;
+    if (strcmp(level, "medium") == 0) return MEDIUM;
+    if (strcmp(level, "hard") == 0) return HARD;
+    return fallback;
+}
+
+// Plays one silent bot-vs-bot game. The coin flip of main is reproduced here:
+// either difficulty may end up moving first, and result->policy[0] is always the first mover.
+bool simulateGame(DifficultyLevel first, DifficultyLevel second,
+                  const BotParams* firstParams, const BotParams* secondParams, GameResult* result) {
+    Player players[2];
+    Fleet fleets[2];
+    bool wasQuiet = quietMode;
+    bool wasHeadless = headlessGame;
+    bool swapped = rand() % 2 != 0;
+    quietMode = true;
+    headlessGame = true;
+
+    if (swapped) {
+        DifficultyLevel temp = first;
+        first = second;
+        second = temp;
+        const BotParams* tempParams = firstParams;
+        firstParams = secondParams;
+        secondParams = tempParams;
+    }
+
+    strcpy(players[0].name, "Bot 1");
+    strcpy(players[1].name, "Bot 2");
+    initializePlayer(&players[0], true, first);
+    initializePlayer(&players[1], true, second);
+    players[0].params = firstParams;
+    players[1].params = secondParams;
+    initializeFleet(&fleets[0]);
+    initializeFleet(&fleets[1]);
+    placeShipsBot(&players[0], &fleets[0]);
+    placeShipsBot(&players[1], &fleets[1]);
+
+    result->policy[0] = first;
+    result->policy[1] = second;
+    result->winner = -1;
+    result->turnsToWin = 0;
+    beginJournalSession(&journalSession, &players[0], &players[1], &fleets[0], &fleets[1], false);
+
+    Player* sides[2] = { &players[0], &players[1] };
+    Fleet* sideFleets[2] = { &fleets[0], &fleets[1] };
+    int current = 0;
+    for (int turn = 0; turn < 2 * MAX_SIM_TURNS; turn++) {
+        int other = 1 - current;
+        if (positionLog) recordPosition(sides, sideFleets, current, false);
+        performBotMove(&players[current], &players[other], &fleets[other], false);
+        if (checkWin(&fleets[other])) {
+            result->winner = current;
+            result->turnsToWin = players[current].turnNumber;
+            break;
+        }
+        current = other;
+    }
+    endJournalSession(&journalSession);
+
+    for (int i = 0; i < SPECIAL_MOVE_TYPES; i++) {
+        result->specialMoves[i] = 0;
+    }
+    for (int p = 0; p < 2; p++) {
+        result->specialMoves[0] += players[p].radarSweepsUsed;
+        result->specialMoves[1] += players[p].smokeScreensUsed;
+        result->specialMoves[2] += players[p].artilleryUsed;
+        result->specialMoves[3] += players[p].torpedoUsed;
+        memcpy(result->hitGrid[p], players[p].grid, sizeof(players[p].grid));
+    }
+
+    result->winnerSeat = result->winner == -1 ? -1 : (swapped ? 1 - result->winner : result->winner);
+    quietMode = wasQuiet;
+    headlessGame = wasHeadless;
+    return result->winner != -1;
+}
+
+void initializeGameStats(GameStats* stats) {
+    memset(stats, 0, sizeof(GameStats));
+}
+
+void recordGameResult(GameStats* stats, const GameResult* result) {
+    int first = result->policy[0];
+    int second = result->policy[1];
+
+    stats->games++;
+    stats->matchups[first][second]++;
+    for (int i = 0; i < SPECIAL_MOVE_TYPES; i++) {
+        stats->specialMoves[i] += result->specialMoves[i];
+    }
+    for (int p = 0; p < 2; p++) {
+        for (int y = 0; y < GRID_SIZE; y++) {
+            for (int x = 0; x < GRID_SIZE; x++) {
+                if (result->hitGrid[p][y][x] == 'X') {
+                    stats->hitHeatmap[y][x]++;
+                }
+            }
+        }
+    }
+
+    if (result->winner == -1) {
+        stats->unfinished++;
+        return;
+    }
+    if (result->winner == 0) {
+        stats->wins[first][second]++;
+        stats->firstMoverWins++;
+    } else {
+        stats->wins[second][first]++;
+    }
+    int turns = result->turnsToWin < MAX_SIM_TURNS ? result->turnsToWin : MAX_SIM_TURNS;
+    stats->turnsHistogram[turns]++;
+}
+
+// Every field is a plain counter, so per-thread (or per-process) aggregates combine by addition
+void mergeGameStats(GameStats* into, const GameStats* from) {
+    into->games += from->games;
+    into->unfinished += from->unfinished;
+    into->firstMoverWins += from->firstMoverWins;
+    for (int a = 0; a < STAT_POLICIES; a++) {
+        for (int b = 0; b < STAT_POLICIES; b++) {
+            into->matchups[a][b] += from->matchups[a][b];
+            into->wins[a][b] += from->wins[a][b];
+        }
+    }
+    for (int t = 0; t <= MAX_SIM_TURNS; t++) {
+        into->turnsHistogram[t] += from->turnsHistogram[t];
+    }
+    for (int i = 0; i < SPECIAL_MOVE_TYPES; i++) {
+        into->specialMoves[i] += from->specialMoves[i];
+    }
+    for (int y = 0; y < GRID_SIZE; y++) {
+        for (int x = 0; x < GRID_SIZE; x++) {
+            into->hitHeatmap[y][x] += from->hitHeatmap[y][x];
+        }
+    }
+}
+
+// Shots-to-win is a small bounded integer, so the histogram gives exact quantiles in fixed memory
+int turnsQuantile(const GameStats* stats, double q) {
+    long long finished = stats->games - stats->unfinished;
+    if (finished <= 0) return 0;
+
+    long long rank = (long long)(q * (double)(finished - 1)) + 1;
+    long long seen = 0;
+    for (int t = 0; t <= MAX_SIM_TURNS; t++) {
+        seen += stats->turnsHistogram[t];
+        if (seen >= rank) return t;
+    }
+    return MAX_SIM_TURNS;
+}
+
+void printGameStats(const GameStats* stats) {
+    const char* levels[STAT_POLICIES] = { "easy", "medium", "hard", "batch hunter" };
+    const char* moves[SPECIAL_MOVE_TYPES] = { "Radar", "Smoke", "Artillery", "Torpedo" };
+    long long finished = stats->games - stats->unfinished;
+
+    printf("Games: %lld (unfinished: %lld)\n", stats->games, stats->unfinished);
+    for (int a = 0; a < STAT_POLICIES; a++) {
+        for (int b = a; b < STAT_POLICIES; b++) {
+            long long games = stats->matchups[a][b] + (a != b ? stats->matchups[b][a] : 0);
+            if (games == 0) continue;
+            if (a == b) {
+                printf("%s vs %s: %lld games\n", levels[a], levels[b], games);
+            } else {
+                printf("%s vs %s: %lld games, %s win rate %.2f%%\n", levels[a], levels[b], games,
+                       levels[a], 100.0 * (double)stats->wins[a][b] / (double)games);
+            }
+        }
+    }
+    if (finished > 0) {
+        printf("First mover win rate: %.2f%%\n", 100.0 * (double)stats->firstMoverWins / (double)finished);
+        printf("Turns to win: p50 %d, p90 %d, p99 %d\n",
+               turnsQuantile(stats, 0.50), turnsQuantile(stats, 0.90), turnsQuantile(stats, 0.99));
+    }
+    if (stats->games > 0) {
+        printf("Special moves per game:");
+        for (int i = 0; i < SPECIAL_MOVE_TYPES; i++) {
+            printf(" %s %.2f", moves[i], (double)stats->specialMoves[i] / (double)stats->games);
+        }
+        printf("\n");
+
+        printf("Hit heatmap (hits per 100 games, both boards):\n");
+        printf("   A   B   C   D   E   F   G   H   I   J\n");
+        for (int y = 0; y < GRID_SIZE; y++) {
+            printf("%2d", y + 1);
+            for (int x = 0; x < GRID_SIZE; x++) {
+                printf(" %3d", (int)(100 * stats->hitHeatmap[y][x] / stats->games));
+            }
+            printf("\n");
+        }
+    }
+}
+
+void runSimulations(long long games, DifficultyLevel first, DifficultyLevel second) {
+    GameStats stats;
+    GameResult result;
+    initializeGameStats(&stats);
+
+    for (long long i = 0; i < games; i++) {
+        simulateGame(first, second, &defaultBotParams, &defaultBotParams, &result);
+        recordGameResult(&stats, &result);
+    }
+
+    printGameStats(&stats);
+    printTranspositionStats();
+}
+
+// Appends one finished human layout to the placement corpus as "symbol x y orientation" per ship
+void recordPlacement(Fleet* fleet) {
+    FILE* corpus = fopen(PLACEMENT_CORPUS_FILE, "a");
+    if (!corpus) return;
+
+    for (int i = 0; i < SHIP_TYPES; i++) {
+        Ship* ship = &fleet->ships[i];
+        fprintf(corpus, "%c %d %d %c ", ship->symbol, ship->position.x, ship->position.y, ship->orientation);
+    }
+    fprintf(corpus, "\n");
+    fclose(corpus);
+}
+
+// Records where each ship ended up on a freshly placed grid (before any hit replaces a symbol)
+void locateShips(char grid[GRID_SIZE][GRID_SIZE], Fleet* fleet) {
+    for (int i = 0; i < SHIP_TYPES; i++) {
+        Ship* ship = &fleet->ships[i];
+        bool found = false;
+        for (int y = 0; y < GRID_SIZE && !found; y++) {
+            for (int x = 0; x < GRID_SIZE && !found; x++) {
+                if (grid[y][x] == ship->symbol) {
+                    ship->position = (Coordinate){ x, y };
+                    ship->orientation = (x + 1 < GRID_SIZE && grid[y][x + 1] == ship->symbol) ? 'h' : 'v';
+                    found = true;
+                }
+            }
+        }
+    }
+}
+
+// Turns the placement corpus into a table of per-ship placement weights.
+// Counts get add-one smoothing and are scaled so a uniformly likely placement weighs PRIOR_UNIFORM_WEIGHT.
+bool learnPlacementPrior(const char* corpusPath, const char* priorPath) {
+    FILE* corpus = fopen(corpusPath, "r");
+    if (!corpus) {
+        printf("Could not open placement corpus %s.\n", corpusPath);
+        return false;
+    }
+
+    static long long counts[SHIP_TYPES][2][GRID_SIZE][GRID_SIZE];
+    long long totals[SHIP_TYPES] = { 0 };
+    int legalPlacements[SHIP_TYPES] = { 0 };
+    memset(counts, 0, sizeof(counts));
+
+    char symbol, orientation;
+    int x, y;
+    while (fscanf(corpus, " %c %d %d %c", &symbol, &x, &y, &orientation) == 4) {
+        if (x < 0 || x >= GRID_SIZE || y < 0 || y >= GRID_SIZE || (orientation != 'h' && orientation != 'v')) {
+            continue;
+        }
+        for (int i = 0; i < SHIP_TYPES; i++) {
+            if (defaultShips[i].symbol == symbol) {
+                counts[i][orientation == 'v'][y][x]++;
+                totals[i]++;
+            }
+        }
+    }
+    fclose(corpus);
+
+    static unsigned short weights[SHIP_TYPES][2][GRID_SIZE][GRID_SIZE];
+    for (int i = 0; i < SHIP_TYPES; i++) {
+        int size = defaultShips[i].size;
+        legalPlacements[i] = 2 * GRID_SIZE * (GRID_SIZE - size + 1);
+        for (int o = 0; o < 2; o++) {
+            for (int py = 0; py < GRID_SIZE; py++) {
+                for (int px = 0; px < GRID_SIZE; px++) {
+                    bool fits = (o == 0) ? (px + size <= GRID_SIZE) : (py + size <= GRID_SIZE);
+                    if (!fits) {
+                        weights[i][o][py][px] = 0;
+                        continue;
+                    }
+                    double frequency = (double)(counts[i][o][py][px] + 1) / (double)(totals[i] + legalPlacements[i]);
+                    double weight = frequency * legalPlacements[i] * PRIOR_UNIFORM_WEIGHT + 0.5;
+                    if (weight < 1) weight = 1;
+                    if (weight > 65535) weight = 65535;
+                    weights[i][o][py][px] = (unsigned short)weight;
+                }
+            }
+        }
+    }
+
+    FILE* out = fopen(priorPath, "wb");
+    if (!out) {
+        printf("Could not write placement prior %s.\n", priorPath);
+        return false;
+    }
+    fwrite(PLACEMENT_PRIOR_MAGIC, 1, 8, out);
+    fwrite(weights, sizeof(weights), 1, out);
+    fclose(out);
+
+    printf("Learned placement prior from %lld layouts into %s.\n", totals[0], priorPath);
+    return true;
+}
+
+// Maps the prior table read-only at startup; a missing or mismatched file leaves the prior uniform
+bool loadPlacementPrior(const char* path) {
+    size_t expected = 8 + sizeof(unsigned short) * SHIP_TYPES * 2 * GRID_SIZE * GRID_SIZE;
+    size_t size;
+    const char* data = mapReadOnlyFile(path, &size);
+    if (!data) return false;
+    if (size != expected || memcmp(data, PLACEMENT_PRIOR_MAGIC, 8) != 0) {
+        unmapReadOnlyFile(data, size);
+        return false;
+    }
+    placementPrior = (const unsigned short*)(data + 8);
+    return true;
+}
+
+// Maps a whole file read-only for the lifetime of the process (Windows builds read it into memory)
+const void* mapReadOnlyFile(const char* path, size_t* size) {
+#ifdef _WIN32
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    void* buffer = length > 0 ? malloc((size_t)length) : NULL;
+    if (!buffer || fread(buffer, 1, (size_t)length, file) != (size_t)length) {
+        free(buffer);
+        fclose(file);
+        return NULL;
+    }
+    fclose(file);
+    *size = (size_t)length;
+    return buffer;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return NULL;
+    }
+    void* mapped = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED) return NULL;
+    *size = (size_t)info.st_size;
+    return mapped;
+#endif
+}
+
+// Releases a file mapReadOnlyFile returned, for loaders that reject its contents
+void unmapReadOnlyFile(const void* data, size_t size) {
+#ifdef _WIN32
+    (void)size;
+    free((void*)data);
+#else
+    munmap((void*)data, size);
+#endif
+}
+
+int placementWeight(int shipIdx, char orientation, int x, int y) {
+    if (!placementPrior) return 1;
+    return placementPrior[((shipIdx * 2 + (orientation == 'v')) * GRID_SIZE + y) * GRID_SIZE + x];
+}
+
+double currentTimeMs() {
+#ifdef _WIN32
+    return 1000.0 * (double)clock() / CLOCKS_PER_SEC;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+#endif
+}
+
+// Whether a bot search may go on: until its deadline in interactive play, and for a fixed amount of
+// work in headless runs, so simulations and the tuner do not depend on machine speed or load
+bool searchBudgetLeft(double deadline, int done, int headlessQuota) {
+    if (headlessGame) return done < headlessQuota;
+    return currentTimeMs() < deadline;
+}
+
+// Plays our own density hunter (getNextTarget) against a layout and returns the shots it needed
+int countShotsToFind(char grid[GRID_SIZE][GRID_SIZE], Fleet* fleet) {
+    Player hunter, target;
+    Fleet targetFleet = *fleet;
+    char sunkShipName[20];
+
+    initializePlayer(&hunter, true, HARD);
+    initializePlayer(&target, true, HARD);
+    memcpy(target.grid, grid, sizeof(target.grid));
+
+    int shots = 0;
+    while (!checkWin(&targetFleet) && shots < GRID_SIZE * GRID_SIZE) {
+        Coordinate coord = getNextTarget(&hunter, &targetFleet);
+        fire(&hunter, &target, &targetFleet, coord, false, sunkShipName);
+        shots++;
+    }
+    return shots;
+}
+
+// Scores random layouts by how long the density hunter takes to clear them, within a time budget,
+// then draws the final layout among the shortlist of best ones so the bot stays unpredictable.
+void placeShipsAdversarial(Player* bot, Fleet* fleet, double budgetMs) {
+    char shortlist[PLACEMENT_SHORTLIST][GRID_SIZE][GRID_SIZE];
+    int shortlistScores[PLACEMENT_SHORTLIST];
+    int shortlistCount = 0;
+    double deadline = currentTimeMs() + budgetMs;
+
+    for (int candidate = 0; candidate < PLACEMENT_CANDIDATES; candidate++) {
+        if (candidate > 0 && currentTimeMs() >= deadline) break;
+
+        char grid[GRID_SIZE][GRID_SIZE];
+        initializeGrid(grid);
+        placeShipsRandomly(grid, fleet);
+        int score = countShotsToFind(grid, fleet);
+
+        // Keep the shortlist sorted from best (most shots) to worst
+        int pos = shortlistCount < PLACEMENT_SHORTLIST ? shortlistCount++ : PLACEMENT_SHORTLIST;
+        while (pos > 0 && shortlistScores[pos - 1] < score) {
+            if (pos < PLACEMENT_SHORTLIST) {
+                memcpy(shortlist[pos], shortlist[pos - 1], sizeof(grid));
+                shortlistScores[pos] = shortlistScores[pos - 1];
+            }
+            pos--;
+        }
+        if (pos < PLACEMENT_SHORTLIST) {
+            memcpy(shortlist[pos], grid, sizeof(grid));
+            shortlistScores[pos] = score;
+        }
+    }
+
+    memcpy(bot->grid, shortlist[rand() % shortlistCount], sizeof(bot->grid));
+}
+
+int* botParamField(BotParams* params, const TunedParam* param) {
+    return (int*)((char*)params + param->offset);
+}
+
+// Lists the constants that actually influence a bot of the given difficulty
+int collectTunedParams(DifficultyLevel difficulty, TunedParam* params) {
+    int count = 0;
+    size_t slot = sizeof(int) * difficulty;
+
+    params[count++] = (TunedParam){ "hitWeight", offsetof(BotParams, hitWeight), 1, 50 };
+    params[count++] = (TunedParam){ "plainWeight", offsetof(BotParams, plainWeight), 1, 10 };
+    params[count++] = (TunedParam){ "checkerboardHunt", offsetof(BotParams, checkerboardHunt), 0, 1 };
+    if (difficulty == EASY) {
+        params[count++] = (TunedParam){ "easyCadence", offsetof(BotParams, easyCadence), 5, 20 };
+    } else {
+        params[count++] = (TunedParam){ "radarChance", offsetof(BotParams, radarChance) + slot, 0, 100 };
+        params[count++] = (TunedParam){ "artilleryChance", offsetof(BotParams, artilleryChance) + slot, 0, 100 };
+        params[count++] = (TunedParam){ "torpedoChance", offsetof(BotParams, torpedoChance) + slot, 0, 100 };
+        params[count++] = (TunedParam){ "smokeChance", offsetof(BotParams, smokeChance) + slot, 0, 100 };
+    }
+    return count;
+}
+
+// Win rate of the candidate against the default parameters; the coin flip in simulateGame balances seats
+double evaluateBotParams(const BotParams* candidate, DifficultyLevel difficulty, int games) {
+    GameResult result;
+    int wins = 0;
+    int decided = 0;
+
+    for (int i = 0; i < games; i++) {
+        if (simulateGame(difficulty, difficulty, candidate, &defaultBotParams, &result)) {
+            decided++;
+            if (result.winnerSeat == 0) wins++;
+        }
+    }
+    return decided > 0 ? (double)wins / decided : 0.0;
+}
+
+// Scores a generation with one forked process per candidate. simulateGame runs on process-wide state
+// (transposition table, particle filters, journal), so processes rather than threads keep the
+// candidates apart. Every child is reseeded from the parent's rand(), so a tuning run stays repeatable
+// for a given seed. Windows builds, and candidates whose fork fails, are evaluated in this process.
+void evaluateGeneration(const BotParams candidates[TUNE_POPULATION], DifficultyLevel difficulty, int games,
+                        double scores[TUNE_POPULATION]) {
+    unsigned int seeds[TUNE_POPULATION];
+    for (int c = 0; c < TUNE_POPULATION; c++) seeds[c] = (unsigned int)rand();
+
+#ifndef _WIN32
+    pid_t children[TUNE_POPULATION];
+    int results[TUNE_POPULATION];
+    fflush(stdout);
+    for (int c = 0; c < TUNE_POPULATION; c++) {
+        int fds[2];
+        children[c] = -1;
+        if (pipe(fds) != 0) continue;
+        children[c] = fork();
+        if (children[c] == 0) {
+            close(fds[0]);
+            srand(seeds[c]);
+            double score = evaluateBotParams(&candidates[c], difficulty, games);
+            _exit(write(fds[1], &score, sizeof(score)) == (ssize_t)sizeof(score) ? 0 : 1);
+        }
+        close(fds[1]);
+        if (children[c] < 0) {
+            close(fds[0]);
+            continue;
+        }
+        results[c] = fds[0];
+    }
+    for (int c = 0; c < TUNE_POPULATION; c++) {
+        if (children[c] < 0) continue;
+        bool received = read(results[c], &scores[c], sizeof(scores[c])) == (ssize_t)sizeof(scores[c]);
+        close(results[c]);
+        waitpid(children[c], NULL, 0);
+        if (!received) children[c] = -1; // Lost child: evaluated below instead
+    }
+    for (int c = 0; c < TUNE_POPULATION; c++) {
+        if (children[c] >= 0) continue;
+        srand(seeds[c]);
+        scores[c] = evaluateBotParams(&candidates[c], difficulty, games);
+    }
+#else
+    for (int c = 0; c < TUNE_POPULATION; c++) {
+        srand(seeds[c]);
+        scores[c] = evaluateBotParams(&candidates[c], difficulty, games);
+    }
+#endif
+}
+
+// Separable evolution strategy: each parameter is searched in a normalized [0, 1] range with its own
+// step size, the mean moves to the average of the best half of every generation, and each step size
+// follows the spread of the selected candidates (a diagonal CMA-ES without the evolution paths).
+void tuneBotParams(int generations, int gamesPerCandidate, DifficultyLevel difficulty) {
+    const int lambda = TUNE_POPULATION;
+    const int mu = lambda / 2;
+    TunedParam params[MAX_TUNED_PARAMS];
+    int count = collectTunedParams(difficulty, params);
+    double mean[MAX_TUNED_PARAMS], sigma[MAX_TUNED_PARAMS];
+    double samples[TUNE_POPULATION][MAX_TUNED_PARAMS], scores[TUNE_POPULATION];
+    BotParams candidates[TUNE_POPULATION];
+    BotParams best = defaultBotParams;
+    double bestScore = -1.0;
+
+    for (int p = 0; p < count; p++) {
+        int value = *botParamField((BotParams*)&defaultBotParams, &params[p]);
+        mean[p] = (double)(value - params[p].min) / (params[p].max - params[p].min);
+        sigma[p] = 0.2;
+    }
+
+    for (int gen = 0; gen < generations; gen++) {
+        for (int c = 0; c < lambda; c++) {
+            candidates[c] = defaultBotParams;
+            for (int p = 0; p < count; p++) {
+                double x = mean[p] + sigma[p] * randomNormal();
+                samples[c][p] = x < 0.0 ? 0.0 : (x > 1.0 ? 1.0 : x);
+                *botParamField(&candidates[c], &params[p]) =
+                    params[p].min + (int)(samples[c][p] * (params[p].max - params[p].min) + 0.5);
+            }
+        }
+        evaluateGeneration(candidates, difficulty, gamesPerCandidate, scores);
+        for (int c = 0; c < lambda; c++) {
+            if (scores[c] > bestScore) {
+                bestScore = scores[c];
+                best = candidates[c];
+            }
+        }
+
+        // Rank candidates by score (insertion sort on indices)
+        int order[TUNE_POPULATION];
+        for (int c = 0; c < lambda; c++) {
+            int pos = c;
+            while (pos > 0 && scores[order[pos - 1]] < scores[c]) {
+                order[pos] = order[pos - 1];
+                pos--;
+            }
+            order[pos] = c;
+        }
+
+        for (int p = 0; p < count; p++) {
+            double newMean = 0.0;
+            for (int i = 0; i < mu; i++) newMean += samples[order[i]][p];
+            newMean /= mu;
+
+            double spread = 0.0;
+            for (int i = 0; i < mu; i++) {
+                double d = samples[order[i]][p] - mean[p];
+                spread += d * d;
+            }
+            spread = squareRoot(spread / mu);
+            sigma[p] = 0.7 * sigma[p] + 0.3 * spread;
+            if (sigma[p] < 0.02) sigma[p] = 0.02;
+            mean[p] = newMean;
+        }
+
+        printf("Generation %d: best %.3f, generation best %.3f\n", gen + 1, bestScore, scores[order[0]]);
+    }
+
+    // Re-measure the winner on a fresh, larger batch so its score is not inflated by selection
+    int finalGames = gamesPerCandidate * 4;
+    double winRate = evaluateBotParams(&best, difficulty, finalGames);
+    double z = 1.96;
+    double denom = 1.0 + z * z / finalGames;
+    double centre = (winRate + z * z / (2.0 * finalGames)) / denom;
+    double margin = z * squareRoot(winRate * (1.0 - winRate) / finalGames + z * z / (4.0 * finalGames * finalGames)) / denom;
+
+    printf("Best parameters:\n");
+    for (int p = 0; p < count; p++) {
+        double low = mean[p] - 2.0 * sigma[p], high = mean[p] + 2.0 * sigma[p];
+        if (low < 0.0) low = 0.0;
+        if (high > 1.0) high = 1.0;
+        printf("  %-16s %4d   (search interval %d..%d)\n", params[p].name, *botParamField(&best, &params[p]),
+               params[p].min + (int)(low * (params[p].max - params[p].min) + 0.5),
+               params[p].min + (int)(high * (params[p].max - params[p].min) + 0.5));
+    }
+    printf("Win rate vs defaults over %d games: %.3f (95%% CI %.3f..%.3f)\n",
+           finalGames, winRate, centre - margin, centre + margin);
+}
+
+// Standard normal draw from the sum of twelve uniforms (Irwin-Hall), good enough for search steps
+double randomNormal() {
+    double sum = 0.0;
+    for (int i = 0; i < 12; i++) {
+        sum += (double)rand() / RAND_MAX;
+    }
+    return sum - 6.0;
+}
+
+// Newton iteration, so the game still links without libm
+double squareRoot(double value) {
+    if (value <= 0.0) return 0.0;
+    double root = value > 1.0 ? value : 1.0;
+    for (int i = 0; i < 60; i++) {
+        double next = 0.5 * (root + value / root);
+        if (next == root) break;
+        root = next;
+    }
+    return root;
+}
+
+void initializeZobristKeys() {
+    // splitmix64 with a fixed seed, so keys (and cache behaviour) are reproducible across runs
+    unsigned long long seed = 0x9E3779B97F4A7C15ULL;
+    unsigned long long* tables[3] = { &zobristCells[0][0], zobristSunk, &zobristParams[0][0] };
+    int sizes[3] = { GRID_SIZE * GRID_SIZE * 2, SHIP_TYPES, 3 * 64 };
+
+    for (int t = 0; t < 3; t++) {
+        for (int i = 0; i < sizes[t]; i++) {
+            unsigned long long z = (seed += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            tables[t][i] = z ^ (z >> 31);
+        }
+    }
+
+    for (int sym = 0; sym < SYMMETRIES; sym++) {
+        for (int y = 0; y < GRID_SIZE; y++) {
+            for (int x = 0; x < GRID_SIZE; x++) {
+                Coordinate mapped = transformCoordinate((Coordinate){ x, y }, sym);
+                symmetryCells[sym][y * GRID_SIZE + x] = mapped.y * GRID_SIZE + mapped.x;
+            }
+        }
+    }
+    zobristReady = true;
+}
+
+// Key of everything the density depends on: tracking grid, sunk ships and the density parameters.
+// The target queue does not feed the density, so it is deliberately left out. Resolved hits hash
+// as the misses the density takes them for. The grid is hashed as it looks after the given symmetry.
+unsigned long long hashDensityState(Player* bot, Fleet* opponentFleet, int symmetry) {
+    char view[GRID_SIZE][GRID_SIZE];
+    densityView(bot, view);
+    unsigned long long key = hashTrackingGrid(view, symmetry);
+    for (int i = 0; i < SHIP_TYPES; i++) {
+        if (opponentFleet->ships[i].sunk) key ^= zobristSunk[i];
+    }
+
+    int densityParams[3] = { bot->params->hitWeight, bot->params->plainWeight, bot->params->checkerboardHunt };
+    for (int p = 0; p < 3; p++) {
+        for (int bit = 0; bit < 32; bit++) {
+            if ((unsigned int)densityParams[p] & (1u << bit)) key ^= zobristParams[p][bit];
+        }
+    }
+    return key;
+}
+
+unsigned long long hashTrackingGrid(char trackingGrid[GRID_SIZE][GRID_SIZE], int symmetry) {
+    if (!zobristReady) initializeZobristKeys();
+
+    unsigned long long key = 0;
+    for (int y = 0; y < GRID_SIZE; y++) {
+        for (int x = 0; x < GRID_SIZE; x++) {
+            char cell = trackingGrid[y][x];
+            int mapped = symmetryCells[symmetry][y * GRID_SIZE + x];
+            if (cell == 'o') {
+                key ^= zobristCells[mapped][0];
+            } else if (cell == '*') {
+                key ^= zobristCells[mapped][1];
+            }
+        }
+    }
+    return key;
+}
+
+unsigned long long densityChecksum(int density[GRID_SIZE][GRID_SIZE]) {
+    unsigned long long sum = 0;
+    for (int y = 0; y < GRID_SIZE; y++) {
+        for (int x = 0; x < GRID_SIZE; x++) {
+            sum = (sum ^ (unsigned int)density[y][x]) * 0x100000001B3ULL;
+        }
+    }
+    return sum;
+}
+
+bool probeTranspositionTable(unsigned long long key, int density[GRID_SIZE][GRID_SIZE]) {
+    TranspositionEntry* bucket = transpositionTable.entries[key & (TRANSPOSITION_BUCKETS - 1)];
+    int* cells = &density[0][0];
+    atomic_fetch_add_explicit(&transpositionTable.lookups, 1, memory_order_relaxed);
+
+    for (int way = 0; way < 2; way++) {
+        TranspositionEntry* entry = &bucket[way];
+        if (atomic_load_explicit(&entry->lastUsed, memory_order_relaxed) == 0) continue;
+        unsigned long long lock = atomic_load_explicit(&entry->lock, memory_order_relaxed);
+        for (int w = 0; w < DENSITY_WORDS; w++) {
+            unsigned long long word = atomic_load_explicit(&entry->density[w], memory_order_relaxed);
+            cells[2 * w] = (int)(unsigned int)word;
+            if (2 * w + 1 < CELL_COUNT) cells[2 * w + 1] = (int)(unsigned int)(word >> 32);
+        }
+        if ((lock ^ densityChecksum(density)) == key) {
+            atomic_store_explicit(&entry->lastUsed,
+                                  atomic_fetch_add_explicit(&transpositionTable.clock, 1, memory_order_relaxed) + 1,
+                                  memory_order_relaxed);
+            atomic_fetch_add_explicit(&transpositionTable.hits, 1, memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Fills an empty way if there is one, otherwise evicts the least recently used of the two. Two
+// threads storing into one entry at once can leave it torn; its lock then matches neither key.
+void storeTranspositionTable(unsigned long long key, int density[GRID_SIZE][GRID_SIZE]) {
+    TranspositionEntry* bucket = transpositionTable.entries[key & (TRANSPOSITION_BUCKETS - 1)];
+    unsigned long long used0 = atomic_load_explicit(&bucket[0].lastUsed, memory_order_relaxed);
+    unsigned long long used1 = atomic_load_explicit(&bucket[1].lastUsed, memory_order_relaxed);
+    TranspositionEntry* victim = used0 <= used1 ? &bucket[0] : &bucket[1];
+    const int* cells = &density[0][0];
+
+    if ((used0 <= used1 ? used0 : used1) != 0) {
+        atomic_fetch_add_explicit(&transpositionTable.evictions, 1, memory_order_relaxed);
+    }
+    for (int w = 0; w < DENSITY_WORDS; w++) {
+        unsigned long long word = (unsigned int)cells[2 * w];
+        if (2 * w + 1 < CELL_COUNT) word |= (unsigned long long)(unsigned int)cells[2 * w + 1] << 32;
+        atomic_store_explicit(&victim->density[w], word, memory_order_relaxed);
+    }
+    atomic_store_explicit(&victim->lock, key ^ densityChecksum(density), memory_order_relaxed);
+    atomic_store_explicit(&victim->lastUsed,
+                          atomic_fetch_add_explicit(&transpositionTable.clock, 1, memory_order_relaxed) + 1,
+                          memory_order_relaxed);
+    atomic_fetch_add_explicit(&transpositionTable.stores, 1, memory_order_relaxed);
+}
+
+void printTranspositionStats() {
+    unsigned long long lookups = atomic_load(&transpositionTable.lookups);
+    unsigned long long hits = atomic_load(&transpositionTable.hits);
+    printf("Density cache: %llu lookups, %llu hits (%.1f%%), %llu stores, %llu evictions\n",
+           lookups, hits, lookups > 0 ? 100.0 * (double)hits / (double)lookups : 0.0,
+           atomic_load(&transpositionTable.stores), atomic_load(&transpositionTable.evictions));
+}
+
+// Symmetry bits: 4 = transpose (applied first), 1 = mirror columns, 2 = mirror rows
+Coordinate transformCoordinate(Coordinate coord, int symmetry) {
+    Coordinate result = coord;
+    if (symmetry & 4) {
+        result.x = coord.y;
+        result.y = coord.x;
+    }
+    if (symmetry & 1) result.x = GRID_SIZE - 1 - result.x;
+    if (symmetry & 2) result.y = GRID_SIZE - 1 - result.y;
+    return result;
+}
+
+int inverseSymmetry(int symmetry) {
+    if (!(symmetry & 4)) return symmetry; // Mirrors are their own inverse
+    // Undoing mirrors then transposing equals transposing then mirroring the other axis
+    return 4 | ((symmetry & 1) << 1) | ((symmetry & 2) >> 1);
+}
+
+// The hunt-mode checkerboard keeps cells with (x + y) even; a single mirror flips that parity
+// whenever GRID_SIZE is even, so only the transforms with zero or two mirrors preserve it.
+bool preservesCheckerboard(int symmetry) {
+    if (GRID_SIZE % 2 != 0) return true;
+    return ((symmetry & 1) != 0) == ((symmetry & 2) != 0);
+}
+
+void transformDensity(int density[GRID_SIZE][GRID_SIZE], int result[GRID_SIZE][GRID_SIZE], int symmetry) {
+    if (!zobristReady) initializeZobristKeys();
+    for (int cell = 0; cell < GRID_SIZE * GRID_SIZE; cell++) {
+        int mapped = symmetryCells[symmetry][cell];
+        result[mapped / GRID_SIZE][mapped % GRID_SIZE] = density[cell / GRID_SIZE][cell % GRID_SIZE];
+    }
+}
+
+// Picks the orientation with the smallest key among the symmetries the density is invariant under,
+// so all mirror images of a state share one cache entry. Returns the symmetry that maps the bot's
+// view onto that canonical orientation.
+int canonicalizeDensityState(Player* bot, Fleet* opponentFleet, unsigned long long* key) {
+    bool checkerboard = bot->params->checkerboardHunt;
+    for (int y = 0; y < GRID_SIZE && checkerboard; y++) {
+        for (int x = 0; x < GRID_SIZE && checkerboard; x++) {
+            if (bot->trackingGrid[y][x] == '*' && !isResolvedHit(bot, x, y)) checkerboard = false;
+        }
+    }
+
+    int best = 0;
+    *key = hashDensityState(bot, opponentFleet, 0);
+
+    // A learned placement prior is not symmetric, so the identity is the only safe choice then
+    if (placementPrior) return best;
+
+    for (int sym = 1; sym < SYMMETRIES; sym++) {
+        if (checkerboard && !preservesCheckerboard(sym)) continue;
+        unsigned long long candidate = hashDensityState(bot, opponentFleet, sym);
+        if (candidate < *key) {
+            *key = candidate;
+            best = sym;
+        }
+    }
+    return best;
+}
+
+// Canonical orientation of a bare tracking grid over all eight symmetries (the book is built from
+// uniformly sampled layouts, so unlike the density engine it has no checkerboard to respect)
+int canonicalTrackingSymmetry(char trackingGrid[GRID_SIZE][GRID_SIZE], unsigned long long* key) {
+    int best = 0;
+    *key = hashTrackingGrid(trackingGrid, 0);
+    for (int sym = 1; sym < SYMMETRIES; sym++) {
+        unsigned long long candidate = hashTrackingGrid(trackingGrid, sym);
+        if (candidate < *key) {
+            *key = candidate;
+            best = sym;
+        }
+    }
+    return best;
+}
+
+// Estimates the hit chance of every cell from layouts consistent with the position, books the best
+// cell, and recurses into the miss and hit outcomes while they are likely enough to sample.
+void expandOpeningNode(char trackingGrid[GRID_SIZE][GRID_SIZE], int depth, int samples,
+                       OpeningEntry* entries, int* count, int capacity) {
+    if (depth == 0 || *count >= capacity) return;
+
+    static FleetSampler sampler;
+    Fleet fleet;
+    initializeFleet(&fleet);
+    int occupied[GRID_SIZE][GRID_SIZE] = { { 0 } };
+    int accepted = 0;
+
+    // Misses and hits become sampler constraints, so every drawn layout is consistent with the
+    // position and the draws are uniform over exactly those layouts
+    FleetConstraints constraints;
+    constraints.must = cellMask(trackingGrid, '*', '*');
+    constraints.mustNot = cellMask(trackingGrid, 'o', 'o');
+    constraints.hits = constraints.must;
+    if (!initializeFleetSampler(&sampler, &fleet, &constraints)) return;
+
+    unsigned int rng = (unsigned int)rand() * 2654435761u | 1;
+    for (int attempt = 0; attempt < samples * 40 && accepted < samples; attempt++) {
+        int picks[SHIP_TYPES];
+        if (!sampleFleet(&sampler, &rng, picks, 1)) continue;
+        accepted++;
+        for (int i = 0; i < SHIP_TYPES; i++) {
+            const unsigned long long* mask = sampler.masks[i][picks[i]];
+            for (int cell = 0; cell < CELL_COUNT; cell++) {
+                if ((mask[cell / 64] >> (cell % 64)) & 1) occupied[cell / GRID_SIZE][cell % GRID_SIZE]++;
+            }
+        }
+    }
+    if (accepted < samples / 10) return; // Too rare to be worth a book entry
+
+    int bestX = -1, bestY = -1;
+    for (int y = 0; y < GRID_SIZE; y++) {
+        for (int x = 0; x < GRID_SIZE; x++) {
+            if (trackingGrid[y][x] == '~' && (bestX == -1 || occupied[y][x] > occupied[bestY][bestX])) {
+                bestX = x;
+                bestY = y;
+            }
+        }
+    }
+    if (bestX == -1) return;
+
+    unsigned long long key;
+    int symmetry = canonicalTrackingSymmetry(trackingGrid, &key);
+    for (int i = 0; i < *count; i++) {
+        if (entries[i].key == key) return; // Transposition of a position already expanded
+    }
+    Coordinate canonical = transformCoordinate((Coordinate){ bestX, bestY }, symmetry);
+    entries[*count].key = key;
+    entries[*count].cell = (unsigned char)(canonical.y * GRID_SIZE + canonical.x);
+    (*count)++;
+
+    char child[GRID_SIZE][GRID_SIZE];
+    memcpy(child, trackingGrid, sizeof(child));
+    child[bestY][bestX] = 'o';
+    expandOpeningNode(child, depth - 1, samples, entries, count, capacity);
+    child[bestY][bestX] = '*';
+    expandOpeningNode(child, depth - 1, samples, entries, count, capacity);
+}
+
+int compareOpeningEntries(const void* a, const void* b) {
+    unsigned long long keyA = ((const OpeningEntry*)a)->key;
+    unsigned long long keyB = ((const OpeningEntry*)b)->key;
+    return keyA < keyB ? -1 : (keyA > keyB ? 1 : 0);
+}
+
+// Book file: magic, entry count, sorted keys, then one cell byte per key
+bool buildOpeningBook(int depth, int samples, const char* path) {
+    int capacity = (1 << (depth < 16 ? depth : 16)) - 1;
+    OpeningEntry* entries = malloc(sizeof(OpeningEntry) * (size_t)capacity);
+    if (!entries) return false;
+
+    char trackingGrid[GRID_SIZE][GRID_SIZE];
+    initializeGrid(trackingGrid);
+    int count = 0;
+    expandOpeningNode(trackingGrid, depth, samples, entries, &count, capacity);
+    qsort(entries, (size_t)count, sizeof(OpeningEntry), compareOpeningEntries);
+
+    FILE* out = fopen(path, "wb");
+    if (!out) {
+        free(entries);
+        printf("Could not write opening book %s.\n", path);
+        return false;
+    }
+    unsigned int header[2] = { (unsigned int)count, 0 };
+    fwrite(OPENING_BOOK_MAGIC, 1, 8, out);
+    fwrite(header, sizeof(header), 1, out);
+    for (int i = 0; i < count; i++) fwrite(&entries[i].key, sizeof(entries[i].key), 1, out);
+    for (int i = 0; i < count; i++) fwrite(&entries[i].cell, 1, 1, out);
+    fclose(out);
+    free(entries);
+
+    printf("Opening book with %d positions written to %s.\n", count, path);
+    return true;
+}
+
+bool loadOpeningBook(const char* path) {
+    size_t size;
+    const char* data = mapReadOnlyFile(path, &size);
+    if (!data) return false;
+    if (size < 16 || memcmp(data, OPENING_BOOK_MAGIC, 8) != 0) {
+        unmapReadOnlyFile(data, size);
+        return false;
+    }
+
+    unsigned int count;
+    memcpy(&count, data + 8, sizeof(count));
+    if (size != 16 + (size_t)count * (sizeof(unsigned long long) + 1)) {
+        unmapReadOnlyFile(data, size);
+        return false;
+    }
+
+    openingKeys = (const unsigned long long*)(data + 16);
+    openingCells = (const unsigned char*)(data + 16 + (size_t)count * sizeof(unsigned long long));
+    openingCount = count;
+    return true;
+}
+
+// The book assumes no ship has been sunk yet, and it was built from uniformly drawn layouts: a bot
+// weighting placements by a learned prior or playing tuned density parameters keeps its own judgement
+bool openingBookApplies(Player* bot, Fleet* opponentFleet) {
+    if (openingCount == 0 || placementPrior) return false;
+    if (bot->params->hitWeight != defaultBotParams.hitWeight || bot->params->plainWeight != defaultBotParams.plainWeight ||
+        bot->params->checkerboardHunt != defaultBotParams.checkerboardHunt) {
+        return false;
+    }
+    for (int i = 0; i < SHIP_TYPES; i++) {
+        if (opponentFleet->ships[i].sunk) return false;
+    }
+    return true;
+}
+
+// A position that several symmetries leave unchanged (the empty board is left unchanged by all eight)
+// maps the booked cell back through any of them, so one is picked at random and the bot does not
+// open on the same cell every game
+bool lookupOpeningMove(char trackingGrid[GRID_SIZE][GRID_SIZE], Coordinate* coord) {
+    unsigned long long key;
+    canonicalTrackingSymmetry(trackingGrid, &key);
+    int symmetries[SYMMETRIES];
+    int symmetryCount = 0;
+    for (int sym = 0; sym < SYMMETRIES; sym++) {
+        if (hashTrackingGrid(trackingGrid, sym) == key) symmetries[symmetryCount++] = sym;
+    }
+    int symmetry = symmetries[rand() % symmetryCount];
+
+    unsigned int low = 0, high = openingCount;
+    while (low < high) {
+        unsigned int mid = low + (high - low) / 2;
+        if (openingKeys[mid] < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (low == openingCount || openingKeys[low] != key) return false;
+
+    Coordinate canonical = { openingCells[low] % GRID_SIZE, openingCells[low] / GRID_SIZE };
+    *coord = transformCoordinate(canonical, inverseSymmetry(symmetry));
+    return trackingGrid[coord->y][coord->x] == '~';
+}
+
+bool initializeGameStore(GameStore* store, int capacity) {
+    memset(store, 0, sizeof(GameStore));
+    store->capacity = capacity;
+    size_t n = (size_t)capacity;
+    bool ok = true;
+
+    for (int side = 0; side < 2; side++) {
+        for (int row = 0; row < GRID_SIZE; row++) {
+            ok &= (store->shipRows[side][row] = calloc(n, sizeof(unsigned short))) != NULL;
+            ok &= (store->shotRows[side][row] = calloc(n, sizeof(unsigned short))) != NULL;
+        }
+        for (int i = 0; i < SHIP_TYPES; i++) {
+            ok &= (store->placements[side][i] = calloc(n, 1)) != NULL;
+        }
+    }
+
+    if (!ok) freeGameStore(store);
+    return ok;
+}
+
+void freeGameStore(GameStore* store) {
+    for (int side = 0; side < 2; side++) {
+        for (int row = 0; row < GRID_SIZE; row++) {
+            free(store->shipRows[side][row]);
+            free(store->shotRows[side][row]);
+        }
+        for (int i = 0; i < SHIP_TYPES; i++) {
+            free(store->placements[side][i]);
+        }
+    }
+    memset(store, 0, sizeof(GameStore));
+}
+
+Bitboard shipPlacementMask(unsigned char placement, int size) {
+    Bitboard mask = { { 0 } };
+    int cell = placement & 0x7F;
+    int x = cell % GRID_SIZE;
+    int y = cell / GRID_SIZE;
+    for (int k = 0; k < size; k++) {
+        if (placement & 0x80) {
+            mask.rows[y + k] |= (unsigned short)(1 << x);
+        } else {
+            mask.rows[y] |= (unsigned short)(1 << (x + k));
+        }
+    }
+    return mask;
+}
+
+int bitboardCount(Bitboard board) {
+    int count = 0;
+    for (int row = 0; row < GRID_SIZE; row++) {
+        for (unsigned int bits = board.rows[row]; bits; bits &= bits - 1) count++;
+    }
+    return count;
+}
+
+Bitboard bitboardAnd(Bitboard a, Bitboard b) {
+    for (int row = 0; row < GRID_SIZE; row++) a.rows[row] &= b.rows[row];
+    return a;
+}
+
+bool bitboardEmpty(Bitboard board) {
+    unsigned short any = 0;
+    for (int row = 0; row < GRID_SIZE; row++) any |= board.rows[row];
+    return any == 0;
+}
+
+// Cells whose character lies in [low, high], e.g. 'A'..'Z' for ships or '~'..'~' for untargeted
+Bitboard cellMask(char grid[GRID_SIZE][GRID_SIZE], char low, char high) {
+    Bitboard mask = { { 0 } };
+    for (int y = 0; y < GRID_SIZE; y++) {
+        for (int x = 0; x < GRID_SIZE; x++) {
+            if (grid[y][x] >= low && grid[y][x] <= high) mask.rows[y] |= (unsigned short)(1 << x);
+        }
+    }
+    return mask;
+}
+
+// 2x2 window kernels. The window anchored at (x, y) covers x..x+1 and y..y+1 clipped to the board,
+// the same area handleEdgeCoordinates gives radar, smoke and artillery. The kernels answer for every
+// anchor at once: bit x of rows[y] of the result is the answer for the window anchored at (x, y).
+// Masks never have bits at or above GRID_SIZE, so shifting the right column in brings in zeros and
+// the last row and column clip for free.
+
+Bitboard windowFootprint(Coordinate anchor) {
+    Bitboard footprint = { { 0 } };
+    unsigned short pair = (unsigned short)((3 << anchor.x) & FULL_ROW);
+    footprint.rows[anchor.y] = pair;
+    if (anchor.y + 1 < GRID_SIZE) footprint.rows[anchor.y + 1] = pair;
+    return footprint;
+}
+
+// Anchors whose window touches the mask: two ORs per row
+Bitboard windowAny(Bitboard mask) {
+    Bitboard any;
+    for (int y = 0; y < GRID_SIZE; y++) {
+        unsigned short column = mask.rows[y] | (y + 1 < GRID_SIZE ? mask.rows[y + 1] : 0);
+        any.rows[y] = column | (column >> 1);
+    }
+    return any;
+}
+
+// Number of mask cells in each window, summed with bit-sliced adders: the four cells of every window
+// are added pairwise (two half adders), then the 2-bit partial sums are combined into 3 bits
+WindowCounts windowCount(Bitboard mask) {
+    WindowCounts counts;
+    for (int y = 0; y < GRID_SIZE; y++) {
+        unsigned short a = mask.rows[y];
+        unsigned short b = a >> 1;
+        unsigned short c = y + 1 < GRID_SIZE ? mask.rows[y + 1] : 0;
+        unsigned short d = c >> 1;
+
+        unsigned short topLow = a ^ b, topHigh = a & b;
+        unsigned short bottomLow = c ^ d, bottomHigh = c & d;
+        unsigned short carry = topLow & bottomLow;
+        counts.bits[0].rows[y] = topLow ^ bottomLow;
+        counts.bits[1].rows[y] = topHigh ^ bottomHigh ^ carry;
+        counts.bits[2].rows[y] = (topHigh & bottomHigh) | (carry & (topHigh ^ bottomHigh));
+    }
+    return counts;
+}
+
+int windowCountAt(const WindowCounts* counts, int x, int y) {
+    return ((counts->bits[0].rows[y] >> x) & 1) |
+           (((counts->bits[1].rows[y] >> x) & 1) << 1) |
+           (((counts->bits[2].rows[y] >> x) & 1) << 2);
+}
+
+void matchMaskScalar(const char* cells, char match, unsigned long long mask[CELL_MASK_WORDS]) {
+    memset(mask, 0, sizeof(unsigned long long) * CELL_MASK_WORDS);
+    for (int i = 0; i < CELL_COUNT; i++) {
+        if (cells[i] == match) mask[i >> 6] |= 1ULL << (i & 63);
+    }
+}
+
+int maskedArgmaxScalar(const int* values, const unsigned long long mask[CELL_MASK_WORDS], int* ties, int* tieCount) {
+    int best = -1;
+    *tieCount = 0;
+    for (int i = 0; i < CELL_COUNT; i++) {
+        if (!((mask[i >> 6] >> (i & 63)) & 1)) continue;
+        if (values[i] > best) {
+            best = values[i];
+            *tieCount = 0;
+        }
+        if (values[i] == best) ties[(*tieCount)++] = i;
+    }
+    return best;
+}
+
+#ifdef SIMD_X86
+// count (<= 16) mask bits from start; chunks never straddle a 64-bit word
+static inline unsigned int flatMaskBits(const unsigned long long mask[CELL_MASK_WORDS], int start, int count) {
+    return (unsigned int)(mask[start >> 6] >> (start & 63)) & ((1u << count) - 1);
+}
+
+// Appends the set bits of a lane mask as cell indices, lowest first
+static inline void appendTies(unsigned int lanes, int base, int* ties, int* tieCount) {
+    while (lanes) {
+        ties[(*tieCount)++] = base + __builtin_ctz(lanes);
+        lanes &= lanes - 1;
+    }
+}
+
+// Cells past the last full vector are handled here by every implementation
+static inline void argmaxTail(const int* values, const unsigned long long mask[CELL_MASK_WORDS], int from,
+                              int* best, int* ties, int* tieCount) {
+    for (int i = from; i < CELL_COUNT; i++) {
+        if (!((mask[i >> 6] >> (i & 63)) & 1)) continue;
+        if (values[i] > *best) {
+            *best = values[i];
+            *tieCount = 0;
+        }
+        if (values[i] == *best) ties[(*tieCount)++] = i;
+    }
+}
+
+__attribute__((target("sse2")))
+void matchMaskSse2(const char* cells, char match, unsigned long long mask[CELL_MASK_WORDS]) {
+    memset(mask, 0, sizeof(unsigned long long) * CELL_MASK_WORDS);
+    __m128i needle = _mm_set1_epi8(match);
+    int i = 0;
+    for (; i + 16 <= CELL_COUNT; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(cells + i));
+        unsigned long long bits = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+        mask[i >> 6] |= bits << (i & 63);
+    }
+    for (; i < CELL_COUNT; i++) {
+        if (cells[i] == match) mask[i >> 6] |= 1ULL << (i & 63);
+    }
+}
+
+// SSE2 has no signed 32-bit max or blend, so both are built from compares and and/andnot
+__attribute__((target("sse2")))
+int maskedArgmaxSse2(const int* values, const unsigned long long mask[CELL_MASK_WORDS], int* ties, int* tieCount) {
+    const __m128i laneBits = _mm_set_epi32(8, 4, 2, 1);
+    const __m128i none = _mm_set1_epi32(-1);
+    int vectorCells = CELL_COUNT / 4 * 4;
+
+    __m128i best = none;
+    for (int i = 0; i < vectorCells; i += 4) {
+        __m128i lanes = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32((int)flatMaskBits(mask, i, 4)), laneBits), laneBits);
+        __m128i v = _mm_or_si128(_mm_and_si128(lanes, _mm_loadu_si128((const __m128i*)(values + i))), _mm_andnot_si128(lanes, none));
+        __m128i greater = _mm_cmpgt_epi32(v, best);
+        best = _mm_or_si128(_mm_and_si128(greater, v), _mm_andnot_si128(greater, best));
+    }
+    int lanesMax[4];
+    _mm_storeu_si128((__m128i*)lanesMax, best);
+    int max = lanesMax[0];
+    for (int k = 1; k < 4; k++) {
+        if (lanesMax[k] > max) max = lanesMax[k];
+    }
+
+    *tieCount = 0;
+    if (max >= 0) {
+        __m128i target = _mm_set1_epi32(max);
+        for (int i = 0; i < vectorCells; i += 4) {
+            __m128i lanes = _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32((int)flatMaskBits(mask, i, 4)), laneBits), laneBits);
+            __m128i equal = _mm_and_si128(lanes, _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(values + i)), target));
+            appendTies((unsigned int)_mm_movemask_ps(_mm_castsi128_ps(equal)), i, ties, tieCount);
+        }
+    }
+    argmaxTail(values, mask, vectorCells, &max, ties, tieCount);
+    return max;
+}
+
+__attribute__((target("avx2")))
+void matchMaskAvx2(const char* cells, char match, unsigned long long mask[CELL_MASK_WORDS]) {
+    memset(mask, 0, sizeof(unsigned long long) * CELL_MASK_WORDS);
+    __m256i needle = _mm256_set1_epi8(match);
+    int i = 0;
+    for (; i + 32 <= CELL_COUNT; i += 32) {
+        __m256i chunk = _mm256_loadu_si256((const __m256i*)(cells + i));
+        unsigned long long bits = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle));
+        mask[i >> 6] |= bits << (i & 63);
+    }
+    for (; i < CELL_COUNT; i++) {
+        if (cells[i] == match) mask[i >> 6] |= 1ULL << (i & 63);
+    }
+}
+
+__attribute__((target("avx2")))
+int maskedArgmaxAvx2(const int* values, const unsigned long long mask[CELL_MASK_WORDS], int* ties, int* tieCount) {
+    const __m256i laneBits = _mm256_set_epi32(128, 64, 32, 16, 8, 4, 2, 1);
+    const __m256i none = _mm256_set1_epi32(-1);
+    int vectorCells = CELL_COUNT / 8 * 8;
+
+    __m256i best = none;
+    for (int i = 0; i < vectorCells; i += 8) {
+        __m256i lanes = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32((int)flatMaskBits(mask, i, 8)), laneBits), laneBits);
+        __m256i v = _mm256_blendv_epi8(none, _mm256_loadu_si256((const __m256i*)(values + i)), lanes);
+        best = _mm256_max_epi32(best, v);
+    }
+    __m128i half = _mm_max_epi32(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+    half = _mm_max_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_max_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    int max = _mm_cvtsi128_si32(half);
+
+    *tieCount = 0;
+    if (max >= 0) {
+        __m256i target = _mm256_set1_epi32(max);
+        for (int i = 0; i < vectorCells; i += 8) {
+            __m256i lanes = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32((int)flatMaskBits(mask, i, 8)), laneBits), laneBits);
+            __m256i equal = _mm256_and_si256(lanes, _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(values + i)), target));
+            appendTies((unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(equal)), i, ties, tieCount);
+        }
+    }
+    argmaxTail(values, mask, vectorCells, &max, ties, tieCount);
+    return max;
+}
+
+// AVX-512BW compares straight into mask registers, and masked loads cover the ragged tail without
+// reading past the grid
+__attribute__((target("avx512f,avx512bw")))
+void matchMaskAvx512(const char* cells, char match, unsigned long long mask[CELL_MASK_WORDS]) {
+    __m512i needle = _mm512_set1_epi8(match);
+    for (int i = 0; i < CELL_MASK_WORDS; i++) {
+        int remaining = CELL_COUNT - i * 64;
+        __mmask64 load = remaining >= 64 ? ~0ULL : (1ULL << remaining) - 1;
+        __m512i chunk = _mm512_maskz_loadu_epi8(load, cells + i * 64);
+        mask[i] = _mm512_mask_cmpeq_epi8_mask(load, chunk, needle);
+    }
+}
+
+__attribute__((target("avx512f,avx512bw")))
+int maskedArgmaxAvx512(const int* values, const unsigned long long mask[CELL_MASK_WORDS], int* ties, int* tieCount) {
+    int vectorCells = CELL_COUNT / 16 * 16;
+
+    __m512i best = _mm512_set1_epi32(-1);
+    for (int i = 0; i < vectorCells; i += 16) {
+        __mmask16 lanes = (__mmask16)flatMaskBits(mask, i, 16);
+        best = _mm512_mask_max_epi32(best, lanes, best, _mm512_loadu_si512(values + i));
+    }
+    int max = _mm512_reduce_max_epi32(best);
+
+    *tieCount = 0;
+    if (max >= 0) {
+        __m512i target = _mm512_set1_epi32(max);
+        for (int i = 0; i < vectorCells; i += 16) {
+            __mmask16 lanes = (__mmask16)flatMaskBits(mask, i, 16);
+            appendTies(_mm512_mask_cmpeq_epi32_mask(lanes, _mm512_loadu_si512(values + i), target), i, ties, tieCount);
+        }
+    }
+    argmaxTail(values, mask, vectorCells, &max, ties, tieCount);
+    return max;
+}
+#endif
+
+// Picks the widest kernels the CPU supports. BATTLESHIP_SIMD=scalar|sse2|avx2 caps the choice, so
+// every path can be exercised (and compared) on one machine.
+void initializeGridKernels() {
+    const char* cap = getenv("BATTLESHIP_SIMD");
+    gridKernels = (GridKernels){ "scalar", matchMaskScalar, maskedArgmaxScalar };
+#ifdef SIMD_X86
+    int limit = 3;
+    if (cap && strcmp(cap, "scalar") == 0) limit = 0;
+    else if (cap && strcmp(cap, "sse2") == 0) limit = 1;
+    else if (cap && strcmp(cap, "avx2") == 0) limit = 2;
+
+    __builtin_cpu_init();
+    if (limit >= 3 && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        gridKernels = (GridKernels){ "avx512", matchMaskAvx512, maskedArgmaxAvx512 };
+    } else if (limit >= 2 && __builtin_cpu_supports("avx2")) {
+        gridKernels = (GridKernels){ "avx2", matchMaskAvx2, maskedArgmaxAvx2 };
+    } else if (limit >= 1 && __builtin_cpu_supports("sse2")) {
+        gridKernels = (GridKernels){ "sse2", matchMaskSse2, maskedArgmaxSse2 };
+    }
+#else
+    (void)cap;
+#endif
+    gridKernelsReady = true;
+}
+
+bool anyCellMatches(char grid[GRID_SIZE][GRID_SIZE], char match) {
+    if (!gridKernelsReady) initializeGridKernels();
+    unsigned long long mask[CELL_MASK_WORDS];
+    gridKernels.matchMask(&grid[0][0], match, mask);
+    unsigned long long any = 0;
+    for (int i = 0; i < CELL_MASK_WORDS; i++) any |= mask[i];
+    return any != 0;
+}
+
+// Row counts are popcounts of the row masks. Column counts add the rows up as bit-sliced 4-bit
+// counters (one lane per column), so neither direction needs a transpose.
+void countCellsPerLine(char grid[GRID_SIZE][GRID_SIZE], char match, int rowCounts[GRID_SIZE], int columnCounts[GRID_SIZE]) {
+    if (!gridKernelsReady) initializeGridKernels();
+    unsigned long long mask[CELL_MASK_WORDS];
+    gridKernels.matchMask(&grid[0][0], match, mask);
+
+    unsigned short slices[5] = { 0 }; // Up to 16 per column
+    for (int y = 0; y < GRID_SIZE; y++) {
+        // The row's bits may straddle two mask words
+        int start = y * GRID_SIZE;
+        unsigned long long bits = mask[start >> 6] >> (start & 63);
+        if ((start & 63) + GRID_SIZE > 64) bits |= mask[(start >> 6) + 1] << (64 - (start & 63));
+        unsigned short row = (unsigned short)(bits & FULL_ROW);
+
+        rowCounts[y] = 0;
+        for (unsigned int left = row; left; left &= left - 1) rowCounts[y]++;
+
+        unsigned short carry = row;
+        for (int bit = 0; bit < 5 && carry; bit++) {
+            unsigned short next = slices[bit] & carry;
+            slices[bit] ^= carry;
+            carry = next;
+        }
+    }
+    for (int x = 0; x < GRID_SIZE; x++) {
+        columnCounts[x] = 0;
+        for (int bit = 0; bit < 5; bit++) columnCounts[x] |= ((slices[bit] >> x) & 1) << bit;
+    }
+}
+
+// Returns the best value over the matching cells (-1 if none match) and every cell index holding
+// it in row-major order, exactly what the scalar scan used to collect
+int argmaxMatchingCells(int values[GRID_SIZE][GRID_SIZE], char grid[GRID_SIZE][GRID_SIZE], char match, int* ties, int* tieCount) {
+    if (!gridKernelsReady) initializeGridKernels();
+    unsigned long long mask[CELL_MASK_WORDS];
+    gridKernels.matchMask(&grid[0][0], match, mask);
+    return gridKernels.maskedArgmax(&values[0][0], mask, ties, tieCount);
+}
+
+// Starts a fresh random game in one lane of the batch
+void refillBatchLane(GameStore* store, BatchScratch* scratch, int lane, int sideToMove) {
+    for (int side = 0; side < 2; side++) {
+        char grid[GRID_SIZE][GRID_SIZE];
+        Fleet fleet;
+        initializeGrid(grid);
+        initializeFleet(&fleet);
+        placeShipsRandomly(grid, &fleet);
+        locateShips(grid, &fleet);
+
+        for (int r = 0; r < GRID_SIZE; r++) {
+            store->shipRows[side][r][lane] = 0;
+            store->shotRows[side][r][lane] = 0;
+            scratch->sunkRows[side][r][lane] = 0;
+        }
+        for (int i = 0; i < SHIP_TYPES; i++) {
+            Ship* ship = &fleet.ships[i];
+            unsigned char placement = (unsigned char)((ship->position.y * GRID_SIZE + ship->position.x) |
+                                                      (ship->orientation == 'v' ? 0x80 : 0));
+            Bitboard mask = shipPlacementMask(placement, ship->size);
+            store->placements[side][i][lane] = placement;
+            scratch->sunk[side][i][lane] = 0;
+            for (int r = 0; r < GRID_SIZE; r++) {
+                scratch->shipMasks[side][i][r][lane] = mask.rows[r];
+                store->shipRows[side][r][lane] |= mask.rows[r];
+            }
+        }
+        scratch->shots[side][lane] = 0;
+    }
+    scratch->firstSide[lane] = (unsigned char)sideToMove;
+    scratch->active[lane] = 1;
+    scratch->rng[lane] = (unsigned int)rand() * 2654435761u + 1u;
+}
+
+// One shot for the given side in every lane. Each phase is a flat loop over lanes on
+// [row][lane] arrays, so the compiler turns it into SIMD across games; only picking the
+// n-th candidate bit per lane stays scalar.
+void batchTurn(GameStore* store, BatchScratch* scratch, int side) {
+    int other = 1 - side;
+    unsigned short live[GRID_SIZE + 2][BATCH_LANES]; // Padded with an empty row above and below
+    unsigned short targetAny[BATCH_LANES];
+    unsigned short huntAny[BATCH_LANES];
+
+    // Hits that do not belong to a sunk ship
+    for (int l = 0; l < BATCH_LANES; l++) {
+        live[0][l] = 0;
+        live[GRID_SIZE + 1][l] = 0;
+        targetAny[l] = 0;
+        huntAny[l] = 0;
+    }
+    for (int r = 0; r < GRID_SIZE; r++) {
+        batchLiveRow(live[r + 1], store->shotRows[side][r], store->shipRows[other][r], scratch->sunkRows[other][r]);
+    }
+
+    // Target mode: unshot neighbours of those hits; hunt mode: unshot checkerboard cells
+    for (int r = 0; r < GRID_SIZE; r++) {
+        unsigned short parity = (unsigned short)((r % 2 == 0 ? 0x5555 : 0xAAAA) & FULL_ROW);
+        batchCandidateRow(scratch->candidates[r], targetAny, huntAny, store->shotRows[side][r],
+                          live[r], live[r + 1], live[r + 2], parity);
+    }
+
+    // Lanes without targets hunt, falling back to any unshot cell once the checkerboard is used up
+    for (int r = 0; r < GRID_SIZE; r++) {
+        unsigned short parity = (unsigned short)((r % 2 == 0 ? 0x5555 : 0xAAAA) & FULL_ROW);
+        batchHuntRow(scratch->candidates[r], store->shotRows[side][r], targetAny, huntAny, parity);
+    }
+
+    // Pick a uniformly random candidate per lane and fire at it
+    for (int l = 0; l < BATCH_LANES; l++) {
+        if (!scratch->active[l]) continue;
+        int total = 0;
+        for (int r = 0; r < GRID_SIZE; r++) total += batchRowBits[scratch->candidates[r][l]];
+        if (total == 0) continue;
+
+        scratch->rng[l] ^= scratch->rng[l] << 13;
+        scratch->rng[l] ^= scratch->rng[l] >> 17;
+        scratch->rng[l] ^= scratch->rng[l] << 5;
+        int pick = (int)(scratch->rng[l] % (unsigned int)total);
+
+        for (int r = 0; r < GRID_SIZE; r++) {
+            unsigned int bits = scratch->candidates[r][l];
+            int count = batchRowBits[bits];
+            if (pick >= count) {
+                pick -= count;
+                continue;
+            }
+            while (pick-- > 0) bits &= bits - 1;
+            store->shotRows[side][r][l] |= (unsigned short)(bits & (~bits + 1));
+            break;
+        }
+        scratch->shots[side][l]++;
+    }
+
+    // Sink checks: a ship is sunk when none of its cells is left unshot
+    for (int i = 0; i < SHIP_TYPES; i++) {
+        unsigned short remaining[BATCH_LANES];
+        unsigned short sunkMask[BATCH_LANES];
+        for (int l = 0; l < BATCH_LANES; l++) remaining[l] = 0;
+        for (int r = 0; r < GRID_SIZE; r++) {
+            batchRemainingRow(remaining, scratch->shipMasks[other][i][r], store->shotRows[side][r]);
+        }
+        for (int l = 0; l < BATCH_LANES; l++) {
+            scratch->sunk[other][i][l] |= (unsigned char)(remaining[l] == 0);
+            sunkMask[l] = remaining[l] == 0 ? 0xFFFF : 0;
+        }
+        for (int r = 0; r < GRID_SIZE; r++) {
+            batchSunkRow(scratch->sunkRows[other][r], scratch->shipMasks[other][i][r], sunkMask);
+        }
+    }
+}
+
+// Row kernels of batchTurn. The restrict parameters promise the compiler that the lane arrays do
+// not overlap, which is what lets it vectorize these loops without runtime alias checks.
+void batchLiveRow(unsigned short* restrict live, const unsigned short* restrict shots,
+                  const unsigned short* restrict ships, const unsigned short* restrict sunk) {
+    for (int l = 0; l < BATCH_LANES; l++) {
+        live[l] = shots[l] & ships[l] & (unsigned short)~sunk[l];
+    }
+}
+
+void batchCandidateRow(unsigned short* restrict candidates, unsigned short* restrict targetAny,
+                       unsigned short* restrict huntAny, const unsigned short* restrict shots,
+                       const unsigned short* restrict above, const unsigned short* restrict live,
+                       const unsigned short* restrict below, unsigned short parity) {
+    for (int l = 0; l < BATCH_LANES; l++) {
+        unsigned short open = (unsigned short)~shots[l] & FULL_ROW;
+        unsigned short near = (unsigned short)((live[l] << 1) | (live[l] >> 1) | above[l] | below[l]);
+        candidates[l] = near & open;
+        targetAny[l] |= near & open;
+        huntAny[l] |= open & parity;
+    }
+}
+
+void batchHuntRow(unsigned short* restrict candidates, const unsigned short* restrict shots,
+                  const unsigned short* restrict targetAny, const unsigned short* restrict huntAny,
+                  unsigned short parity) {
+    for (int l = 0; l < BATCH_LANES; l++) {
+        unsigned short open = (unsigned short)~shots[l] & FULL_ROW;
+        unsigned short hunt = huntAny[l] ? (unsigned short)(open & parity) : open;
+        candidates[l] = targetAny[l] ? candidates[l] : hunt;
+    }
+}
+
+void batchRemainingRow(unsigned short* restrict remaining, const unsigned short* restrict ship,
+                       const unsigned short* restrict shots) {
+    for (int l = 0; l < BATCH_LANES; l++) {
+        remaining[l] |= ship[l] & (unsigned short)~shots[l];
+    }
+}
+
+void batchSunkRow(unsigned short* restrict sunkRows, const unsigned short* restrict ship,
+                  const unsigned short* restrict sunkMask) {
+    for (int l = 0; l < BATCH_LANES; l++) {
+        sunkRows[l] |= ship[l] & sunkMask[l];
+    }
+}
+
+void finishBatchLane(GameStore* store, BatchScratch* scratch, int lane, int winner, GameStats* stats) {
+    GameResult result;
+    int first = scratch->firstSide[lane];
+
+    result.policy[0] = BATCH_POLICY;
+    result.policy[1] = BATCH_POLICY;
+    result.winner = winner == first ? 0 : 1;
+    result.winnerSeat = result.winner;
+    result.turnsToWin = scratch->shots[winner][lane];
+    for (int i = 0; i < SPECIAL_MOVE_TYPES; i++) result.specialMoves[i] = 0;
+
+    for (int side = 0; side < 2; side++) {
+        int seat = side == first ? 0 : 1;
+        for (int y = 0; y < GRID_SIZE; y++) {
+            unsigned short hits = store->shipRows[side][y][lane] & store->shotRows[1 - side][y][lane];
+            for (int x = 0; x < GRID_SIZE; x++) {
+                result.hitGrid[seat][y][x] = (hits & (1 << x)) ? 'X' : '~';
+            }
+        }
+    }
+    recordGameResult(stats, &result);
+    scratch->active[lane] = 0;
+}
+
+// Advances BATCH_LANES independent bitboard-hunter games in lockstep; finished lanes are refilled
+// from the worker's remaining game count until it runs out. The worker touches nothing shared but
+// rand() and the read-only tables runBatchSimulation fills before starting it.
+void* batchSimulationThread(void* arg) {
+    BatchWorker* worker = (BatchWorker*)arg;
+    GameStore store;
+    BatchScratch* scratch = calloc(1, sizeof(BatchScratch));
+    long long started = 0;
+
+    initializeGameStats(&worker->stats);
+    worker->totalShots = 0;
+    worker->ready = scratch && initializeGameStore(&store, BATCH_LANES);
+    if (!worker->ready) {
+        free(scratch);
+        return NULL;
+    }
+
+    for (int l = 0; l < BATCH_LANES && started < worker->games; l++, started++) {
+        refillBatchLane(&store, scratch, l, 0);
+    }
+
+    int side = 0;
+    int activeLanes = started < BATCH_LANES ? (int)started : BATCH_LANES;
+    while (activeLanes > 0) {
+        batchTurn(&store, scratch, side);
+
+        for (int l = 0; l < BATCH_LANES; l++) {
+            if (!scratch->active[l]) continue;
+            int other = 1 - side;
+            if (scratch->sunk[other][0][l] & scratch->sunk[other][1][l] &
+                scratch->sunk[other][2][l] & scratch->sunk[other][3][l]) {
+                worker->totalShots += scratch->shots[0][l] + scratch->shots[1][l];
+                finishBatchLane(&store, scratch, l, side, &worker->stats);
+                if (started < worker->games) {
+                    refillBatchLane(&store, scratch, l, other); // Lane picks up at the other side's move
+                    started++;
+                } else {
+                    activeLanes--;
+                }
+            }
+        }
+        side = 1 - side;
+    }
+
+    freeGameStore(&store);
+    free(scratch);
+    return NULL;
+}
+
+// Splits the games over one lockstep simulator per core; each keeps its own GameStats, and the
+// aggregates are merged once every worker is done
+void runBatchSimulation(long long games) {
+    static BatchWorker workers[MAX_BATCH_THREADS];
+    GameStats stats;
+    long long totalShots = 0;
+    bool ready = true;
+
+    // Shared tables are built here, so the workers only ever read them: the row popcounts and the
+    // empty-board placement table behind placeShipsRandomly
+    for (int bits = 1; bits < (1 << GRID_SIZE); bits++) {
+        batchRowBits[bits] = (unsigned char)(batchRowBits[bits >> 1] + (bits & 1));
+    }
+    char grid[GRID_SIZE][GRID_SIZE];
+    Fleet fleet;
+    initializeGrid(grid);
+    initializeFleet(&fleet);
+    placeShipsRandomly(grid, &fleet);
+
+    int threads = 1;
+#ifndef _WIN32
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = cores < 1 ? 1 : (cores > MAX_BATCH_THREADS ? MAX_BATCH_THREADS : (int)cores);
+    if (games < (long long)threads * BATCH_LANES) threads = games > BATCH_LANES ? (int)(games / BATCH_LANES) : 1;
+#endif
+    for (int t = 0; t < threads; t++) {
+        workers[t].games = games / threads + (t < games % threads ? 1 : 0);
+    }
+
+    double startMs = currentTimeMs();
+#ifndef _WIN32
+    pthread_t handles[MAX_BATCH_THREADS];
+    bool started[MAX_BATCH_THREADS] = { false };
+    for (int t = 1; t < threads; t++) {
+        started[t] = pthread_create(&handles[t], NULL, batchSimulationThread, &workers[t]) == 0;
+    }
+    batchSimulationThread(&workers[0]);
+    for (int t = 1; t < threads; t++) {
+        if (started[t]) {
+            pthread_join(handles[t], NULL);
+        } else {
+            batchSimulationThread(&workers[t]);
+        }
+    }
+#else
+    batchSimulationThread(&workers[0]);
+#endif
+    double elapsed = currentTimeMs() - startMs;
+
+    initializeGameStats(&stats);
+    for (int t = 0; t < threads; t++) {
+        ready &= workers[t].ready;
+        mergeGameStats(&stats, &workers[t].stats);
+        totalShots += workers[t].totalShots;
+    }
+    if (!ready) {
+        printf("Not enough memory for the batch simulator.\n");
+        return;
+    }
+
+    printf("Batch policy: checkerboard hunt, random adjacent targeting, no special moves (%d threads)\n", threads);
+    printGameStats(&stats);
+    printf("%lld shots in %.1f ms (%.1f million shots/s)\n", totalShots, elapsed,
+           elapsed > 0 ? totalShots / elapsed / 1000.0 : 0.0);
+}
+
+// Position notation: one line, eight fields separated by single spaces
+//   <grid 0> <grid 1> <tracking 0> <tracking 1> <side 0> <side 1> <to move> <mode>
+// A grid lists its rows top to bottom separated by '/', a number standing for that many '~' cells
+// (10 is an empty row). Own grids hold ship symbols, in lowercase once hit, and 'o' for misses.
+// Tracking grids hold 'o' misses, '*' hits, '#' hits already attributed to a sunk ship, and '+' or
+// '-' for unfired cells a radar sweep showed to be ship or water. A side is its kind ('p' human,
+// 'e' 'm' 'h' bot difficulty) and turn number, then r and the radar sweeps used, a and t with '+'
+// or '-' for the special in hand and the times it was fired, and s with each smoke screen deployed
+// ('x' once lifted) or '-' for none:  h14r2a+1t-0sB3,x
+// <to move> is 0 or 1 and <mode> 'n', or 'h' for hard tracking (the human's misses stay hidden).
+// Returns the line's length, written to text without a newline.
+int formatPosition(Player* players[2], Fleet* fleets[2], int toMove, bool hardMode, char* text) {
+    char cells[4][GRID_SIZE][GRID_SIZE];
+    for (int side = 0; side < 2; side++) {
+        Player* player = players[side];
+        memcpy(cells[side], player->grid, sizeof(cells[side]));
+        for (int i = 0; i < SHIP_TYPES; i++) {
+            Ship* ship = &fleets[side]->ships[i];
+            unsigned char placement = (unsigned char)((ship->position.y * GRID_SIZE + ship->position.x) |
+                                                      (ship->orientation == 'v' ? 0x80 : 0));
+            Bitboard mask = shipPlacementMask(placement, ship->size);
+            for (int y = 0; y < GRID_SIZE; y++) {
+                for (int x = 0; x < GRID_SIZE; x++) {
+                    if (((mask.rows[y] >> x) & 1) && cells[side][y][x] == 'X') cells[side][y][x] = (char)tolower(ship->symbol);
+                }
+            }
+        }
+
+        memcpy(cells[2 + side], player->trackingGrid, sizeof(cells[2 + side]));
+        for (int y = 0; y < GRID_SIZE; y++) {
+            for (int x = 0; x < GRID_SIZE; x++) {
+                char* cell = &cells[2 + side][y][x];
+                if (*cell == '*' && isResolvedHit(player, x, y)) *cell = '#';
+                if (*cell == '~' && ((player->radarContacts.rows[y] >> x) & 1)) *cell = '+';
+                if (*cell == '~' && ((player->radarClear.rows[y] >> x) & 1)) *cell = '-';
+            }
+        }
+    }
+
+    int length = 0;
+    for (int field = 0; field < 4; field++) {
+        for (int y = 0; y < GRID_SIZE; y++) {
+            int water = 0;
+            for (int x = 0; x <= GRID_SIZE; x++) {
+                if (x < GRID_SIZE && cells[field][y][x] == '~') {
+                    water++;
+                    continue;
+                }
+                if (water > 0) length += sprintf(text + length, "%d", water);
+                water = 0;
+                if (x < GRID_SIZE) text[length++] = cells[field][y][x];
+            }
+            text[length++] = y + 1 < GRID_SIZE ? '/' : ' ';
+        }
+    }
+
+    for (int side = 0; side < 2; side++) {
+        Player* player = players[side];
+        length += sprintf(text + length, "%c%dr%da%c%dt%c%ds", player->isBot ? "emh"[player->difficulty] : 'p',
+                          player->turnNumber, player->radarSweepsUsed, player->artilleryAvailable ? '+' : '-',
+                          player->artilleryUsed, player->torpedoAvailable ? '+' : '-', player->torpedoUsed);
+        if (player->smokeScreensUsed == 0) text[length++] = '-';
+        for (int i = 0; i < player->smokeScreensUsed; i++) {
+            if (i > 0) text[length++] = ',';
+            SmokeScreen* smoke = &player->smokeScreens[i];
+            if (smoke->active) {
+                length += sprintf(text + length, "%c%d", 'A' + smoke->coord.x, smoke->coord.y + 1);
+            } else {
+                text[length++] = 'x';
+            }
+        }
+        text[length++] = ' ';
+    }
+
+    length += sprintf(text + length, "%d %c", toMove, hardMode ? 'h' : 'n');
+    return length;
+}
+
+// Appends the position to the --record-positions file
+void recordPosition(Player* players[2], Fleet* fleets[2], int toMove, bool hardMode) {
+    char text[POSITION_TEXT_MAX + 1];
+    int length = formatPosition(players, fleets, toMove, hardMode, text);
+    text[length] = '\n';
+    fwrite(text, 1, (size_t)length + 1, positionLog);
+}
+
+// Reads one grid field into cells, water runs expanded. Returns the first character after the field,
+// or NULL if the field does not describe exactly GRID_SIZE rows of GRID_SIZE cells.
+const char* parseGridField(const char* text, const char* end, char cells[GRID_SIZE][GRID_SIZE]) {
+    for (int y = 0; y < GRID_SIZE; y++) {
+        int x = 0;
+        while (text < end && *text != '/' && *text != ' ') {
+            if (isdigit((unsigned char)*text)) {
+                int water = 0;
+                while (text < end && isdigit((unsigned char)*text)) water = water * 10 + (*text++ - '0');
+                if (water == 0 || x + water > GRID_SIZE) return NULL;
+                while (water-- > 0) cells[y][x++] = '~';
+            } else {
+                if (x == GRID_SIZE) return NULL;
+                cells[y][x++] = *text++;
+            }
+        }
+        if (x != GRID_SIZE) return NULL;
+        if (y + 1 < GRID_SIZE) {
+            if (text == end || *text != '/') return NULL;
+            text++;
+        }
+    }
+    return text;
+}
+
+// Reads one side field (kind, turn number, abilities, smoke screens) into an initialized player.
+// Returns the first character after the field, or NULL if it is malformed.
+const char* parseSideField(const char* text, const char* end, Player* player) {
+    char buffer[64];
+    size_t length = 0;
+    while (text + length < end && text[length] != ' ') length++;
+    if (length == 0 || length >= sizeof(buffer)) return NULL;
+    memcpy(buffer, text, length);
+    buffer[length] = '\0';
+
+    char kind, artillery, torpedo;
+    int consumed = 0;
+    if (sscanf(buffer, "%c%dr%da%c%dt%c%ds%n", &kind, &player->turnNumber, &player->radarSweepsUsed, &artillery,
+               &player->artilleryUsed, &torpedo, &player->torpedoUsed, &consumed) != 7 || consumed == 0) {
+        return NULL;
+    }
+    if (kind == '\0' || !strchr("emhp", kind)) return NULL;
+    if ((artillery != '+' && artillery != '-') || (torpedo != '+' && torpedo != '-')) return NULL;
+    if (player->radarSweepsUsed < 0 || player->radarSweepsUsed > MAX_RADAR_SWEEPS) return NULL;
+    player->isBot = kind != 'p';
+    player->difficulty = kind == 'e' ? EASY : (kind == 'h' ? HARD : MEDIUM);
+    strcpy(player->name, player->isBot ? "Bot" : "Player");
+    player->artilleryAvailable = artillery == '+';
+    player->torpedoAvailable = torpedo == '+';
+
+    const char* smoke = buffer + consumed;
+    if (strcmp(smoke, "-") == 0) return text + length;
+    while (*smoke) {
+        if (player->smokeScreensUsed == SHIP_TYPES) return NULL;
+        SmokeScreen* screen = &player->smokeScreens[player->smokeScreensUsed++];
+        if (*smoke == 'x') {
+            screen->active = false;
+            smoke++;
+        } else {
+            int column = toupper((unsigned char)*smoke) - 'A';
+            char* after;
+            long row = strtol(smoke + 1, &after, 10);
+            if (column < 0 || column >= GRID_SIZE || row < 1 || row > GRID_SIZE || after == smoke + 1) return NULL;
+            screen->coord = (Coordinate){ column, (int)row - 1 };
+            screen->active = true;
+            smoke = after;
+        }
+        if (*smoke == ',') smoke++;
+        else if (*smoke) return NULL;
+    }
+    return text + length;
+}
+
+// Rebuilds a position from one line of notation (see formatPosition), with fleets located from the
+// grids, shot histories from the opponent's grid and every live hit queued for a bot's targeting
+// mode. Other per-turn bot state (pending sinks, last artillery result) comes back empty.
+bool parsePosition(const char* text, size_t length, Position* position) {
+    const char* end = text + length;
+    char cells[4][GRID_SIZE][GRID_SIZE];
+    for (int field = 0; field < 4; field++) {
+        text = parseGridField(text, end, cells[field]);
+        if (!text || text == end || *text++ != ' ') return false;
+    }
+
+    for (int side = 0; side < 2; side++) {
+        Player* player = &position->players[side];
+        initializePlayer(player, false, MEDIUM);
+        text = parseSideField(text, end, player);
+        if (!text || text == end || *text++ != ' ') return false;
+    }
+    if (end - text != 3 || (text[0] != '0' && text[0] != '1') || text[1] != ' ' || (text[2] != 'n' && text[2] != 'h')) {
+        return false;
+    }
+    position->toMove = text[0] - '0';
+    position->hardMode = text[2] == 'h';
+
+    for (int side = 0; side < 2; side++) {
+        Player* player = &position->players[side];
+        Player* opponent = &position->players[1 - side];
+        Fleet* fleet = &position->fleets[side];
+        initializeFleet(fleet);
+
+        // One pass sorts the cells by ship; anything but water, misses and ship symbols is malformed
+        Bitboard cellsOfShip[SHIP_TYPES] = { { { 0 } } };
+        int first[SHIP_TYPES];
+        for (int i = 0; i < SHIP_TYPES; i++) first[i] = -1;
+        for (int y = 0; y < GRID_SIZE; y++) {
+            for (int x = 0; x < GRID_SIZE; x++) {
+                char c = cells[side][y][x];
+                player->grid[y][x] = c;
+                if (c == '~') continue;
+                if (c != 'o') {
+                    int i = 0;
+                    while (i < SHIP_TYPES && fleet->ships[i].symbol != toupper((unsigned char)c)) i++;
+                    if (i == SHIP_TYPES) return false;
+                    if (first[i] < 0) first[i] = y * GRID_SIZE + x;
+                    cellsOfShip[i].rows[y] |= (unsigned short)(1 << x);
+                    if (c == fleet->ships[i].symbol) continue;
+                    fleet->ships[i].hits++;
+                    player->grid[y][x] = 'X';
+                }
+                opponent->shotHistory.rows[y] |= (unsigned short)(1 << x);
+            }
+        }
+
+        // Each ship's cells have to be exactly one straight placement of it
+        for (int i = 0; i < SHIP_TYPES; i++) {
+            Ship* ship = &fleet->ships[i];
+            if (first[i] < 0) return false;
+            int x = first[i] % GRID_SIZE;
+            int y = first[i] / GRID_SIZE;
+            bool vertical = !((cellsOfShip[i].rows[y] >> x) & 2);
+            if ((vertical ? y : x) + ship->size > GRID_SIZE) return false;
+            Bitboard expected = shipPlacementMask((unsigned char)(first[i] | (vertical ? 0x80 : 0)), ship->size);
+            if (memcmp(&expected, &cellsOfShip[i], sizeof(Bitboard)) != 0) return false;
+            ship->position = (Coordinate){ x, y };
+            ship->orientation = vertical ? 'v' : 'h';
+            updateShipStatus(ship);
+            if (ship->sunk) {
+                opponent->shipsSunk++;
+                player->shipsRemaining--;
+            }
+        }
+
+        for (int y = 0; y < GRID_SIZE; y++) {
+            for (int x = 0; x < GRID_SIZE; x++) {
+                char c = cells[2 + side][y][x];
+                unsigned short bit = (unsigned short)(1 << x);
+                if (c == '#') player->resolvedHits.rows[y] |= bit;
+                if (c == '+') player->radarContacts.rows[y] |= bit;
+                if (c == '-') player->radarClear.rows[y] |= bit;
+                if (c == '#') c = '*';
+                if (c == '+' || c == '-') c = '~';
+                if (c != '~' && c != 'o' && c != '*') return false;
+                player->trackingGrid[y][x] = c;
+            }
+        }
+    }
+
+    for (int side = 0; side < 2; side++) {
+        Player* player = &position->players[side];
+        if (!player->isBot) continue;
+        for (int y = 0; y < GRID_SIZE; y++) {
+            for (int x = 0; x < GRID_SIZE; x++) {
+                if (player->trackingGrid[y][x] == '*' && !isResolvedHit(player, x, y)) addAdjacentTargets(player, (Coordinate){ x, y });
+            }
+        }
+    }
+    return true;
+}
+
+// Maps a position file and indexes its lines; blank lines and lines starting with ';' are skipped
+bool loadPositionSuite(const char* path, PositionSuite* suite) {
+    memset(suite, 0, sizeof(*suite));
+    suite->text = mapReadOnlyFile(path, &suite->size);
+    if (!suite->text) return false;
+
+    size_t capacity = 0;
+    size_t offset = 0;
+    while (offset < suite->size) {
+        const char* newline = memchr(suite->text + offset, '\n', suite->size - offset);
+        size_t next = newline ? (size_t)(newline - suite->text) + 1 : suite->size;
+        char first = suite->text[offset];
+        if (first != '\n' && first != '\r' && first != ';') {
+            if (suite->count == capacity) {
+                capacity = capacity ? 2 * capacity : 4096;
+                size_t* grown = realloc(suite->offsets, sizeof(size_t) * capacity);
+                if (!grown) {
+                    free(suite->offsets);
+                    suite->offsets = NULL;
+                    return false;
+                }
+                suite->offsets = grown;
+            }
+            suite->offsets[suite->count++] = offset;
+        }
+        offset = next;
+    }
+    return true;
+}
+
+// Length of a suite line without its line ending
+size_t positionLength(const PositionSuite* suite, size_t index) {
+    const char* start = suite->text + suite->offsets[index];
+    const char* limit = suite->text + suite->size;
+    const char* newline = memchr(start, '\n', (size_t)(limit - start));
+    size_t length = (size_t)((newline ? newline : limit) - start);
+    if (length > 0 && start[length - 1] == '\r') length--;
+    return length;
+}
+
+// Loads a suite, then times parsing, calculateProbabilityGrid for the side to move and a full
+// performBotMove where that side is a bot. The grids are folded into a checksum, so a suite run
+// before and after a change shows whether the density engine's answers moved.
+void benchmarkPositions(const char* path) {
+    PositionSuite suite;
+    double start = currentTimeMs();
+    if (!loadPositionSuite(path, &suite)) {
+        printf("Could not load positions from %s.\n", path);
+        return;
+    }
+    double loadMs = currentTimeMs() - start;
+
+    static Position position;
+    size_t valid = 0;
+    start = currentTimeMs();
+    for (size_t i = 0; i < suite.count; i++) {
+        if (parsePosition(suite.text + suite.offsets[i], positionLength(&suite, i), &position)) valid++;
+    }
+    double parseMs = currentTimeMs() - start;
+    printf("%zu positions (%zu malformed) loaded in %.1f ms, parsed in %.1f ms (%.2f us each)\n", suite.count,
+           suite.count - valid, loadMs, parseMs, suite.count ? parseMs * 1000.0 / suite.count : 0.0);
+    if (valid == 0) {
+        free(suite.offsets);
+        return;
+    }
+
+    unsigned long long checksum = 0;
+    double densityMs = 0.0;
+    for (size_t i = 0; i < suite.count; i++) {
+        if (!parsePosition(suite.text + suite.offsets[i], positionLength(&suite, i), &position)) continue;
+        int grid[GRID_SIZE][GRID_SIZE];
+        double t = currentTimeMs();
+        calculateProbabilityGrid(&position.players[position.toMove], &position.fleets[1 - position.toMove], grid);
+        densityMs += currentTimeMs() - t;
+        checksum = (checksum ^ densityChecksum(grid)) * 1099511628211ULL;
+    }
+    printf("calculateProbabilityGrid: %.2f us per position, checksum %016llx\n", densityMs * 1000.0 / valid, checksum);
+
+    bool wasQuiet = quietMode;
+    quietMode = true;
+    size_t moves = 0;
+    double moveMs = 0.0;
+    for (size_t i = 0; i < suite.count; i++) {
+        if (!parsePosition(suite.text + suite.offsets[i], positionLength(&suite, i), &position)) continue;
+        Player* mover = &position.players[position.toMove];
+        Player* opponent = &position.players[1 - position.toMove];
+        if (!mover->isBot || checkWin(&position.fleets[1 - position.toMove])) continue;
+        double t = currentTimeMs();
+        performBotMove(mover, opponent, &position.fleets[1 - position.toMove], position.hardMode);
+        moveMs += currentTimeMs() - t;
+        moves++;
+    }
+    quietMode = wasQuiet;
+    if (moves > 0) printf("performBotMove: %.3f ms per move over %zu bot moves\n", moveMs / moves, moves);
+    free(suite.offsets);
+}